@@ -18,8 +18,23 @@
 #define GL_GLEXT_PROTOTYPES
 #include <GLFW/glfw3.h>
 #include <math.h>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdarg.h>
+#include <new>
 
 # include <cstdlib>
+# include <cstring>
+# include <cstdio>
+# include <cstddef>
 # include <iostream>
 
 using namespace std;
@@ -30,14 +45,248 @@ using namespace std;
 
 void QueryGLVersion();
 bool CheckGLErrors();
+void InitializeDebugOutput();
+void BeginAsynchronousDebugOutput();
 
 string LoadSource(const string &filename);
+string AddSharedShaderCode(const string &source);
 GLuint CompileShader(GLenum shaderType, const string &source);
 GLuint LinkProgram(GLuint vertexShader, GLuint fragmentShader);
-vector<float> vertices;
-vector<float> colors;
+uint64_t HashBytes(const void *data, size_t size, uint64_t hash = 14695981039346656037ull);
+string ProgramCacheKey(const string &vertexSource, const string &fragmentSource);
+GLuint LoadProgramBinary(const string &key);
+void SaveProgramBinary(GLuint program, const string &key);
+void UploadBufferData(GLenum target, GLsizeiptr size, const void *data, GLenum usage);
+void UploadBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void *data);
+
+// driver and renderer description filled in by QueryGLVersion()
+string glDriverDescription;
+
+// leaves the floats that resize() adds uninitialized, the generators write
+// every one of them anyway and zeroing them first would double the traffic
+template <typename T>
+struct UninitializedAllocator : allocator<T>
+{
+    template <typename U>
+    struct rebind { typedef UninitializedAllocator<U> other; };
+
+    UninitializedAllocator() {}
+
+    template <typename U>
+    UninitializedAllocator(const UninitializedAllocator<U> &) {}
+
+    template <typename U>
+    void construct(U *element) { ::new ((void *)element) U; }
+
+    template <typename U, typename... Arguments>
+    void construct(U *element, Arguments &&... arguments)
+    {
+        ::new ((void *)element) U(std::forward<Arguments>(arguments)...);
+    }
+};
+typedef vector<float, UninitializedAllocator<float> > FloatBuffer;
+
+FloatBuffer vertices;
+FloatBuffer colors;
 vector<int> elements;
 
+// time spent generating geometry and uploading it to buffers, summed over the
+// run, and the most geometry any one scene held, for the benchmark report
+struct MyRenderStats
+{
+    double   generationMilliseconds;
+    double   uploadMilliseconds;
+    uint64_t uploadBytes;
+    uint64_t peakHostBytes;
+    uint64_t peakGpuBytes;
+
+    MyRenderStats() : generationMilliseconds(0), uploadMilliseconds(0), uploadBytes(0),
+        peakHostBytes(0), peakGpuBytes(0)
+    {}
+};
+MyRenderStats renderStats;
+
+// raises the peaks of the render statistics to the geometry a scene holds
+void noteMemoryUse(uint64_t hostBytes, uint64_t gpuBytes)
+{
+    renderStats.peakHostBytes = max(renderStats.peakHostBytes, hostBytes);
+    renderStats.peakGpuBytes = max(renderStats.peakGpuBytes, gpuBytes);
+}
+
+// --------------------------------------------------------------------------
+// Allocation tracking, compiled in with -DTRACK_ALLOCATIONS
+//
+// Every operator new and delete of the program is counted against the
+// innermost AllocationScope open on the calling thread, or against "other"
+// outside of any scope. Memory is charged to the scope that allocated it,
+// so the live and peak bytes of a scope include what it handed on.
+
+#ifdef TRACK_ALLOCATIONS
+
+const bool ALLOCATION_TRACKING = true;
+
+const int MAX_ALLOCATION_SCOPES = 32;
+
+struct AllocationCounters
+{
+    const char          *name;
+    atomic<uint64_t>    allocations;
+    atomic<uint64_t>    frees;
+    atomic<uint64_t>    bytes;
+    atomic<int64_t>     live;
+    atomic<int64_t>     peak;
+};
+
+// zero-initialized before any constructor runs, scope 0 is "other"
+AllocationCounters allocationScopes[MAX_ALLOCATION_SCOPES];
+atomic<int> allocationScopeCount(1);
+mutex allocationScopeMutex;
+thread_local int currentAllocationScope = 0;
+
+// sits in front of every block to remember its size and scope, 16 bytes so
+// the block keeps the alignment malloc gave it
+struct AllocationHeader
+{
+    uint64_t size;
+    uint64_t scope;
+};
+
+/**
+ * @brief AllocationScopeIndex
+ * @param name a string literal, scopes are told apart by its address
+ * @return the counters of the named scope, registering it on first use
+ */
+int AllocationScopeIndex(const char *name)
+{
+    int count = allocationScopeCount.load();
+    for (int i = 1; i < count; i++)
+        if (allocationScopes[i].name == name)
+            return i;
+
+    lock_guard<mutex> lock(allocationScopeMutex);
+    count = allocationScopeCount.load();
+    for (int i = 1; i < count; i++)
+        if (allocationScopes[i].name == name)
+            return i;
+    if (count == MAX_ALLOCATION_SCOPES)
+        return 0;
+
+    allocationScopes[count].name = name;
+    allocationScopeCount.store(count + 1);
+    return count;
+}
+
+void *TrackedAllocate(size_t size)
+{
+    AllocationHeader *header = (AllocationHeader *)malloc(sizeof(AllocationHeader) + size);
+    if (!header)
+        return NULL;
+    header->size = size;
+    header->scope = currentAllocationScope;
+
+    AllocationCounters &counters = allocationScopes[header->scope];
+    counters.allocations++;
+    counters.bytes += size;
+    int64_t live = counters.live += size;
+    int64_t peak = counters.peak.load();
+    while (live > peak && !counters.peak.compare_exchange_weak(peak, live))
+        ;
+    return header + 1;
+}
+
+void TrackedFree(void *block)
+{
+    if (!block)
+        return;
+
+    AllocationHeader *header = (AllocationHeader *)block - 1;
+    AllocationCounters &counters = allocationScopes[header->scope];
+    counters.frees++;
+    counters.live -= header->size;
+    free(header);
+}
+
+void *operator new(size_t size)
+{
+    void *block = TrackedAllocate(size);
+    if (!block) throw bad_alloc();
+    return block;
+}
+
+void *operator new[](size_t size)
+{
+    void *block = TrackedAllocate(size);
+    if (!block) throw bad_alloc();
+    return block;
+}
+
+void *operator new(size_t size, const nothrow_t &) noexcept { return TrackedAllocate(size); }
+void *operator new[](size_t size, const nothrow_t &) noexcept { return TrackedAllocate(size); }
+void operator delete(void *block) noexcept { TrackedFree(block); }
+void operator delete[](void *block) noexcept { TrackedFree(block); }
+void operator delete(void *block, const nothrow_t &) noexcept { TrackedFree(block); }
+void operator delete[](void *block, const nothrow_t &) noexcept { TrackedFree(block); }
+#if __cplusplus >= 201402L
+void operator delete(void *block, size_t) noexcept { TrackedFree(block); }
+void operator delete[](void *block, size_t) noexcept { TrackedFree(block); }
+#endif
+
+// charges every allocation of the calling thread to the named scope until
+// it goes out of scope again
+struct AllocationScope
+{
+    int previous;
+
+    explicit AllocationScope(const char *name) : previous(currentAllocationScope)
+    {
+        currentAllocationScope = AllocationScopeIndex(name);
+    }
+
+    ~AllocationScope()
+    {
+        currentAllocationScope = previous;
+    }
+};
+
+// total number of allocations so far, over all scopes
+uint64_t AllocationCount()
+{
+    uint64_t total = 0;
+    for (int i = 0; i < allocationScopeCount.load(); i++)
+        total += allocationScopes[i].allocations.load();
+    return total;
+}
+
+void PrintAllocationSummary()
+{
+    allocationScopes[0].name = "other";
+
+    printf("%-16s %12s %12s %14s %14s %14s\n", "Allocations", "count", "frees", "bytes", "peak live", "live now");
+    for (int i = 0; i < allocationScopeCount.load(); i++)
+    {
+        AllocationCounters &counters = allocationScopes[i];
+        printf("%-16s %12llu %12llu %14llu %14lld %14lld\n", counters.name,
+               (unsigned long long)counters.allocations.load(), (unsigned long long)counters.frees.load(),
+               (unsigned long long)counters.bytes.load(), (long long)counters.peak.load(),
+               (long long)counters.live.load());
+    }
+    fflush(stdout);
+}
+
+#else
+
+const bool ALLOCATION_TRACKING = false;
+
+struct AllocationScope
+{
+    explicit AllocationScope(const char *) {}
+};
+
+uint64_t AllocationCount() { return 0; }
+void PrintAllocationSummary() {}
+
+#endif
+
 // --------------------------------------------------------------------------
 // Functions to set up OpenGL shader programs for rendering
 
@@ -48,30 +297,62 @@ struct MyShader
     GLuint  fragment;
     GLuint  program;
 
+    // true if the program was loaded from the on-disk binary cache
+    bool    fromCache;
+
     // initialize shader and program names to zero (OpenGL reserved value)
-    MyShader() : vertex(0), fragment(0), program(0)
+    MyShader() : vertex(0), fragment(0), program(0), fromCache(false)
     {}
 };
 
-// load, compile, and link shaders, returning true if successful
-bool InitializeShaders(MyShader *shader)
+// load a linked program for the given shader files from the binary cache, or
+// compile and link it from source and cache the result, true if successful
+bool InitializeProgram(MyShader *shader, const string &vertexFile, const string &fragmentFile)
 {
-    // load shader source from files
-    string vertexSource = LoadSource("vertex.glsl");
-    string fragmentSource = LoadSource("fragment.glsl");
+    AllocationScope allocations("shaders");
+
+    // load shader source from files, with the shared colour functions
+    string vertexSource = LoadSource(vertexFile);
+    string fragmentSource = LoadSource(fragmentFile);
+    if (vertexSource.empty() || fragmentSource.empty()) return false;
+    vertexSource = AddSharedShaderCode(vertexSource);
+    fragmentSource = AddSharedShaderCode(fragmentSource);
     if (vertexSource.empty() || fragmentSource.empty()) return false;
 
+    // try the cached binary first, it is only valid for this exact source
+    // text on this exact driver
+    string key = ProgramCacheKey(vertexSource, fragmentSource);
+    shader->program = LoadProgramBinary(key);
+    shader->fromCache = shader->program != 0;
+    if (shader->fromCache) return !CheckGLErrors();
+
     // compile shader source into shader objects
     shader->vertex = CompileShader(GL_VERTEX_SHADER, vertexSource);
     shader->fragment = CompileShader(GL_FRAGMENT_SHADER, fragmentSource);
 
-    // link shader program
+    // link shader program and store it for the next launch
     shader->program = LinkProgram(shader->vertex, shader->fragment);
+    SaveProgramBinary(shader->program, key);
 
     // check for OpenGL errors and return false if error occurred
     return !CheckGLErrors();
 }
 
+// colour rules of vertex.glsl, part one uploads no colours at all
+const int COLOUR_FROM_ATTRIBUTE = 0;
+const int COLOUR_NESTED_SQUARES = 1;
+const int COLOUR_TINTED_INSTANCE = 2;
+
+// toggled with the C key, 0 for the assignment colours and 1 for a heat palette,
+// the ColourScheme uniform of colour.glsl that every shader program shares
+int COLOUR_SCHEME = 0;
+
+// load, compile, and link shaders, returning true if successful
+bool InitializeShaders(MyShader *shader)
+{
+    return InitializeProgram(shader, "vertex.glsl", "fragment.glsl");
+}
+
 // deallocate shader-related objects
 void DestroyShaders(MyShader *shader)
 {
@@ -90,11 +371,16 @@ struct MyGeometry
     // OpenGL names for array buffer objects, vertex array object
     GLuint  vertexBuffer;
     GLuint  colourBuffer;
+    GLuint  instanceBuffer;
     GLuint  vertexArray;
     GLsizei elementCount;
 
+    // 3 when the buffers hold one third of the Sierpinski triangle, 1 otherwise
+    GLsizei instanceCount;
+
     // initialize object names to zero (OpenGL reserved value)
-    MyGeometry() : vertexBuffer(0), colourBuffer(0), vertexArray(0), elementCount(0)
+    MyGeometry() : vertexBuffer(0), colourBuffer(0), instanceBuffer(0), vertexArray(0),
+                   elementCount(0), instanceCount(1)
     {}
 };
 
@@ -105,6 +391,16 @@ bool InitializeGeometry(MyGeometry *geometry)
     // input variables in the vertex shader
     const GLuint VERTEX_INDEX = 0;
     const GLuint COLOUR_INDEX = 1;
+    const GLuint OFFSET_INDEX = 2;
+    const GLuint TINT_INDEX = 3;
+
+    // offset from the left third and colour tint of the left, upper and right
+    // thirds of the Sierpinski triangle, each third brightens its own channel
+    const float thirds[] = {
+        0.f,   0.f,   1.f, 0.f, 0.f,
+        0.25f, 0.5f,  0.f, 0.f, 1.f,
+        0.5f,  0.f,   0.f, 1.f, 0.f,
+    };
 
     // create an array buffer object for storing our vertices
     glGenBuffers(1, &geometry->vertexBuffer);
@@ -130,6 +426,17 @@ bool InitializeGeometry(MyGeometry *geometry)
     glVertexAttribPointer(COLOUR_INDEX, 3, GL_FLOAT, GL_FALSE, 0, 0);
     glEnableVertexAttribArray(COLOUR_INDEX);
 
+    // and advance through the thirds once per instance
+    glGenBuffers(1, &geometry->instanceBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, geometry->instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(thirds), thirds, GL_STATIC_DRAW);
+    glVertexAttribPointer(OFFSET_INDEX, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), 0);
+    glVertexAttribDivisor(OFFSET_INDEX, 1);
+    glEnableVertexAttribArray(OFFSET_INDEX);
+    glVertexAttribPointer(TINT_INDEX, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (const void *)(2 * sizeof(float)));
+    glVertexAttribDivisor(TINT_INDEX, 1);
+    glEnableVertexAttribArray(TINT_INDEX);
+
     // unbind our buffers, resetting to default state
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
@@ -146,6 +453,7 @@ void DestroyGeometry(MyGeometry *geometry)
     glDeleteVertexArrays(1, &geometry->vertexArray);
     glDeleteBuffers(1, &geometry->vertexBuffer);
     glDeleteBuffers(1, &geometry->colourBuffer);
+    glDeleteBuffers(1, &geometry->instanceBuffer);
 }
 
 /**
@@ -160,580 +468,5036 @@ void DestroyGeometry(MyGeometry *geometry)
 bool PART_ONE = false;
 bool PART_TWO = false;
 bool PART_THREE = false;
+bool PART_FOUR = false;
+bool PART_FIVE = false;
+bool PART_SIX = false;
+
+int PART_ONE_LEVELS = 1;
+int PART_TWO_LEVELS = 1;
+int PART_THREE_LEVELS = 1;
+int PART_FOUR_LEVELS = 1;
+int PART_FIVE_LEVELS = 1;
+int PART_SIX_LEVELS = 1;
+
+// number of parts the left/right arrow keys cycle through
+const int PART_COUNT = 6;
+
+/**
+ * @brief currentPart
+ * @return the number of the part being shown, 1 to PART_COUNT, or 0 before
+ * the start key has been pressed
+ */
+int currentPart()
+{
+    if(PART_ONE) return 1;
+    if(PART_TWO) return 2;
+    if(PART_THREE) return 3;
+    if(PART_FOUR) return 4;
+    if(PART_FIVE) return 5;
+    if(PART_SIX) return 6;
+    return 0;
+}
 
-int BASE_TRIANGLE = 0;
-int LEFT = 1;
-int UP = 2;
-int RIGHT = 3;
+void selectPart(int part)
+{
+    PART_ONE = (part == 1);
+    PART_TWO = (part == 2);
+    PART_THREE = (part == 3);
+    PART_FOUR = (part == 4);
+    PART_FIVE = (part == 5);
+    PART_SIX = (part == 6);
+}
+
+/**
+ * @brief partLevels
+ * @return the level counter of the given part
+ */
+int *partLevels(int part)
+{
+    switch(part)
+    {
+    case 1: return &PART_ONE_LEVELS;
+    case 2: return &PART_TWO_LEVELS;
+    case 3: return &PART_THREE_LEVELS;
+    case 4: return &PART_FOUR_LEVELS;
+    case 5: return &PART_FIVE_LEVELS;
+    default: return &PART_SIX_LEVELS;
+    }
+}
 
-struct Point
+// geometry is in floats for the GPU, the deep zoom of parts one and three
+// subdivides the same shapes in doubles until they are small enough for floats
+template <typename Real>
+struct PointOf
 {
-     float x;
-     float y;
+     Real x;
+     Real y;
 };
 
-struct Line
+// shapes store each corner once, the edges are implied by consecutive
+// corners (the last corner connects back to the first one)
+template <typename Real>
+struct TriangleOf
 {
-   Point startPoint;
-   Point endPoint;
+    PointOf<Real> left;     // lower left corner
+    PointOf<Real> top;      // apex
+    PointOf<Real> right;    // lower right corner
 };
 
-struct Triangle
+// 32 bytes in floats, so two squares share a cache line and none straddles one
+template <typename Real>
+struct alignas(8 * sizeof(Real)) SquareOf
 {
-    Line leftLine;
-    Line rightLine;
-    Line LowerLine;
+    PointOf<Real> corners[4];
 };
 
-struct Square
+typedef PointOf<float> Point;
+typedef TriangleOf<float> Triangle;
+typedef SquareOf<float> Square;
+
+typedef PointOf<double> PrecisePoint;
+typedef TriangleOf<double> PreciseTriangle;
+typedef SquareOf<double> PreciseSquare;
+
+static_assert(sizeof(Triangle) == 6 * sizeof(float), "Triangle should only hold its corners");
+static_assert(sizeof(Square) == 8 * sizeof(float), "Square should only hold its corners");
+
+/**
+ * @brief midpoint
+ * @return the point halfway between p and q
+ */
+template <typename Real>
+constexpr PointOf<Real> midpoint(const PointOf<Real> &p, const PointOf<Real> &q)
+{
+    return PointOf<Real>{ (p.x + q.x)/2, (p.y + q.y)/2 };
+}
+
+// receives the primitives of a generator instead of the global vertices and
+// colors when set, every primitive is followed by exactly one colour call
+struct PrimitiveSink
 {
-    Line leftLine;
-    Line upperLine;
-    Line rightLine;
-    Line LowerLine;
+    virtual ~PrimitiveSink() {}
+    virtual void line(float x1, float y1, float x2, float y2) = 0;
+    virtual void triangle(const Triangle &triangle) = 0;
+    virtual void colour(float r, float g, float b) = 0;
 };
 
+PrimitiveSink *primitiveSink = NULL;
+
+// cleared while parts one and two are generated for the window, their vertex
+// shader works out the colours from the vertex index so none are produced
+bool GENERATE_COLOURS = true;
+
 /**
  * ================================================================================================
  *
- * The following code section targets part one of the assignment
+ * The following code section targets the subdivision engine shared by the fractals
  *
  * ================================================================================================
  */
 
 /**
- * @brief getSquare
- * @param value
- * @return Reurns square cornered with points provided
+ * A fractal policy tells subdivide() how to generate one fractal:
+ *
+ *      Shape                       the piece that is subdivided, a Triangle or a Square
+ *      Branch                      what a piece hands down to its children for the colour rule
+ *      CHILDREN                    the number of pieces each piece splits into
+ *      EMIT_EVERY_LEVEL            whether every piece is emitted or only the last level
+ *      child(shape, i)             the i-th child of a piece
+ *      branch(branch, i)           the branch of the i-th child
+ *      emit(shape, branch, sink)   passes a piece with its colour to the sink
+ *      skip(branch, depth)         accounts for a piece the deep zoom culls, parts one and three
+ *
+ * child() and emit() also take the double precision shapes of the deep zoom.
+ * The policy and the sink are both template parameters, so the compiler builds
+ * one recursion per combination with every call inlined and no runtime
+ * dispatch. A new fractal only needs a new policy.
  */
-Square getSquare(Point P1, Point P2, Point P3, Point P4)
+template <typename Fractal, typename Sink>
+constexpr void subdivide(Fractal &fractal, const typename Fractal::Shape &shape,
+                         typename Fractal::Branch branch, int depth, Sink &sink)
 {
-    Square baseSquare;
-    baseSquare.leftLine.startPoint.x = P1.x;
-    baseSquare.leftLine.startPoint.y = P1.x;
-    baseSquare.leftLine.endPoint.x = P2.x;
-    baseSquare.leftLine.endPoint.y = P2.y;
-
-    baseSquare.upperLine.startPoint.x = P2.x;
-    baseSquare.upperLine.startPoint.y = P2.y;
-    baseSquare.upperLine.endPoint.x = P3.x;
-    baseSquare.upperLine.endPoint.y = P3.y;
-
-    baseSquare.rightLine.startPoint.x = P3.x;
-    baseSquare.rightLine.startPoint.y = P3.y;
-    baseSquare.rightLine.endPoint.x = P4.x;
-    baseSquare.rightLine.endPoint.y = P4.y;
-
-    baseSquare.LowerLine.startPoint.x = P4.x;
-    baseSquare.LowerLine.startPoint.y = P4.y;
-    baseSquare.LowerLine.endPoint.x = P1.x;
-    baseSquare.LowerLine.endPoint.y = P1.y;
+    if(Fractal::EMIT_EVERY_LEVEL || depth == 0)
+        fractal.emit(shape, branch, sink);
+    if(depth == 0)
+        return;
 
-    return baseSquare;
+    for(int i = 0; i < Fractal::CHILDREN; i++)
+        subdivide(fractal, Fractal::child(shape, i), Fractal::branch(branch, i), depth - 1, sink);
 }
 
-void bufferLine(float x1, float y1, float x2, float y2)
+// writes primitives into float arrays already sized for all of them, with one
+// colour per vertex, the carpet only writes its instances to positions
+struct ArraySink
 {
-    vertices.push_back(x1);
-    vertices.push_back(y1);
-
-    vertices.push_back(x2);
-    vertices.push_back(y2);
-}
+    float *positions;
+    float *colours;
 
-void bufferColorsOfLine(float r, float g, float b)
-{
-    colors.push_back(r);
-    colors.push_back(g);
-    colors.push_back(b);
+    // colours may be null when the shader colours the primitives
+    constexpr void colour(int vertices, float r, float g, float b)
+    {
+        if(!colours)
+            return;
 
-    colors.push_back(r);
-    colors.push_back(g);
-    colors.push_back(b);
-}
+        for(int i = 0; i < vertices; i++, colours += 3)
+        {
+            colours[0] = r;
+            colours[1] = g;
+            colours[2] = b;
+        }
+    }
 
-void bufferSquareLine(float x1, float y1, float x2, float y2, bool isDiamond, float Dcolor)
-{
-    bufferLine(x1, y1, x2, y2);
-    if(isDiamond)
+    constexpr void line(const Point &start, const Point &end, float r, float g, float b)
     {
-        //Diamond
-        bufferColorsOfLine(0.001, 0.001, Dcolor);
+        positions[0] = start.x;
+        positions[1] = start.y;
+        positions[2] = end.x;
+        positions[3] = end.y;
+        positions += 4;
+        colour(2, r, g, b);
     }
 
-    else{
-        //Square
-        bufferColorsOfLine(Dcolor, Dcolor, Dcolor);
+    constexpr void triangle(const Triangle &triangle, float r, float g, float b)
+    {
+        positions[0] = triangle.left.x;
+        positions[1] = triangle.left.y;
+        positions[2] = triangle.top.x;
+        positions[3] = triangle.top.y;
+        positions[4] = triangle.right.x;
+        positions[5] = triangle.right.y;
+        positions += 6;
+        colour(3, r, g, b);
     }
-}
 
-void displaySquare(Square sqr, int isDiamond, float Dcolor)
-{
-    bufferSquareLine(sqr.leftLine.startPoint.x, sqr.leftLine.startPoint.y,
-                     sqr.leftLine.endPoint.x, sqr.leftLine.endPoint.y, isDiamond, Dcolor);
-    bufferSquareLine(sqr.upperLine.startPoint.x, sqr.upperLine.startPoint.y,
-                     sqr.upperLine.endPoint.x, sqr.upperLine.endPoint.y, isDiamond, Dcolor);
-    bufferSquareLine(sqr.rightLine.startPoint.x, sqr.rightLine.startPoint.y,
-                     sqr.rightLine.endPoint.x, sqr.rightLine.endPoint.y, isDiamond, Dcolor);
-    bufferSquareLine(sqr.LowerLine.startPoint.x, sqr.LowerLine.startPoint.y,
-                     sqr.LowerLine.endPoint.x, sqr.LowerLine.endPoint.y, isDiamond, Dcolor);
-}
+    // lower left corner and side of the square
+    constexpr void instance(const Square &square)
+    {
+        positions[0] = square.corners[0].x;
+        positions[1] = square.corners[0].y;
+        positions[2] = square.corners[3].x - square.corners[0].x;
+        positions += 3;
+    }
+};
 
-/**
- * @brief getNextSquare
- * @param oldSquare
- * @return given oldSquare/oldDiamond, this function will return the nested square or the nested diamond inside it
- */
-Square getNextSquare(Square oldSquare)
+// hands primitives on to the primitive sink of an export
+struct ForwardingSink
 {
-    Square nextSquare;
-    nextSquare.leftLine.startPoint.x = (oldSquare.leftLine.startPoint.x + oldSquare.leftLine.endPoint.x)/ 2;
-    nextSquare.leftLine.startPoint.y = (oldSquare.leftLine.startPoint.y + oldSquare.leftLine.endPoint.y)/ 2;
-    nextSquare.leftLine.endPoint.x = (oldSquare.upperLine.startPoint.x + oldSquare.upperLine.endPoint.x)/ 2;
-    nextSquare.leftLine.endPoint.y = (oldSquare.upperLine.startPoint.y + oldSquare.upperLine.endPoint.y)/ 2;
+    PrimitiveSink *sink;
 
-    nextSquare.upperLine.startPoint.x = (oldSquare.upperLine.startPoint.x + oldSquare.upperLine.endPoint.x)/ 2;
-    nextSquare.upperLine.startPoint.y = (oldSquare.upperLine.startPoint.y + oldSquare.upperLine.endPoint.y)/ 2;
-    nextSquare.upperLine.endPoint.x = (oldSquare.rightLine.startPoint.x + oldSquare.rightLine.endPoint.x)/ 2;
-    nextSquare.upperLine.endPoint.y = (oldSquare.rightLine.startPoint.y + oldSquare.rightLine.endPoint.y)/ 2;
-
-    nextSquare.rightLine.startPoint.x = (oldSquare.rightLine.startPoint.x + oldSquare.rightLine.endPoint.x)/ 2;
-    nextSquare.rightLine.startPoint.y = (oldSquare.rightLine.startPoint.y + oldSquare.rightLine.endPoint.y)/ 2;
-    nextSquare.rightLine.endPoint.x = (oldSquare.LowerLine.startPoint.x + oldSquare.LowerLine.endPoint.x)/ 2;
-    nextSquare.rightLine.endPoint.y = (oldSquare.LowerLine.startPoint.y + oldSquare.LowerLine.endPoint.y)/ 2;
-
-    nextSquare.LowerLine.startPoint.x = (oldSquare.LowerLine.startPoint.x + oldSquare.LowerLine.endPoint.x)/ 2;
-    nextSquare.LowerLine.startPoint.y = (oldSquare.LowerLine.startPoint.y + oldSquare.LowerLine.endPoint.y)/ 2;
-    nextSquare.LowerLine.endPoint.x = (oldSquare.leftLine.startPoint.x + oldSquare.leftLine.endPoint.x)/ 2;
-    nextSquare.LowerLine.endPoint.y = (oldSquare.leftLine.startPoint.y + oldSquare.leftLine.endPoint.y)/ 2;
+    void line(const Point &start, const Point &end, float r, float g, float b)
+    {
+        sink->line(start.x, start.y, end.x, end.y);
+        sink->colour(r, g, b);
+    }
 
-    return nextSquare;
-}
+    void triangle(const Triangle &triangle, float r, float g, float b)
+    {
+        sink->triangle(triangle);
+        sink->colour(r, g, b);
+    }
+};
 
-void renderSquaresAndDiamonds(int level)
+// appends primitives to the global vertices and colors one by one, for
+// output whose size is not known in advance
+struct AppendSink
 {
-    //Construct the points for the base square
-    Point one, two, three, four;
-    one.x = -0.9f; one.y = -0.9f;
-    two.x = -0.9f; two.y = 0.9f;
-    three.x = 0.9f; three.y = 0.9f;
-    four.x = 0.9f; four.y = -0.9f;
-
-    //Get the base square and dispaly it
-    Square baseSqr = getSquare(one, two, three, four);
+    void colour(int vertices, float r, float g, float b)
+    {
+        if(!GENERATE_COLOURS)
+            return;
 
-    Square nextSquare = baseSqr;
-    float ChangeInColor = 0.1;
+        for(int i = 0; i < vertices; i++)
+        {
+            colors.push_back(r);
+            colors.push_back(g);
+            colors.push_back(b);
+        }
+    }
 
-    for(int i = 0; i < level; i++)
+    void line(const Point &start, const Point &end, float r, float g, float b)
     {
-        float Dcolor = ((float)i * ChangeInColor) + ChangeInColor;
+        vertices.push_back(start.x);
+        vertices.push_back(start.y);
+        vertices.push_back(end.x);
+        vertices.push_back(end.y);
+        colour(2, r, g, b);
+    }
 
-        //Display square
-        displaySquare(nextSquare, false, Dcolor);
-        nextSquare = getNextSquare(nextSquare);
+    void triangle(const Triangle &triangle, float r, float g, float b)
+    {
+        vertices.push_back(triangle.left.x);
+        vertices.push_back(triangle.left.y);
+        vertices.push_back(triangle.top.x);
+        vertices.push_back(triangle.top.y);
+        vertices.push_back(triangle.right.x);
+        vertices.push_back(triangle.right.y);
+        colour(3, r, g, b);
+    }
+};
 
-        //Display the diamond
-        displaySquare(nextSquare, true, 1 - Dcolor - 0.01);
-        nextSquare = getNextSquare(nextSquare);
+/**
+ * @brief generateFractal
+ * Subdivides the shape into the primitive sink when one is set, otherwise
+ * appends the primitives, count of them with the given number of corners,
+ * to the global vertices and colors.
+ */
+template <typename Fractal>
+void generateFractal(Fractal &fractal, const typename Fractal::Shape &shape,
+                     typename Fractal::Branch branch, int depth, uint64_t count, int corners)
+{
+    if(primitiveSink)
+    {
+        ForwardingSink sink = { primitiveSink };
+        subdivide(fractal, shape, branch, depth, sink);
+        return;
     }
-}
 
+    size_t firstPosition = vertices.size();
+    size_t firstColour = colors.size();
+    vertices.resize(firstPosition + count * corners * 2);
+    if(GENERATE_COLOURS)
+        colors.resize(firstColour + count * corners * 3);
 
+    ArraySink sink = { &vertices[firstPosition], GENERATE_COLOURS ? &colors[firstColour] : NULL };
+    subdivide(fractal, shape, branch, depth, sink);
+}
 
 /**
  * ================================================================================================
  *
- * The following code section targets part two of the assignment
+ * The following code section targets part one of the assignment
  *
  * ================================================================================================
  */
 
-void addColors(float i, float maximum_value)
+/**
+ * @brief getSquare
+ * @param value
+ * @return Reurns square cornered with points provided
+ */
+template <typename Real>
+constexpr SquareOf<Real> getSquare(PointOf<Real> P1, PointOf<Real> P2, PointOf<Real> P3, PointOf<Real> P4)
 {
-    colors.push_back(0.f);
-    colors.push_back(0.f);
-    colors.push_back(1 * (i/maximum_value));
+    SquareOf<Real> baseSquare = {};
+    baseSquare.corners[0] = P1;
+    baseSquare.corners[1] = P2;
+    baseSquare.corners[2] = P3;
+    baseSquare.corners[3] = P4;
 
-    colors.push_back(0.f);
-    colors.push_back(0.f);
-    colors.push_back(1 * (i/maximum_value));
+    return baseSquare;
 }
 
-void doPartTwo(int rotationNumbers)
+void bufferLine(float x1, float y1, float x2, float y2)
 {
-    float maximum_value = (rotationNumbers * 360) * (M_PI/180);
-
-    for (float i = 0; i < maximum_value; i+=0.01)
+    if(primitiveSink)
     {
-        float x1 = (i * cos(i)) / maximum_value;
-        float y1 = (-i * sin(i)) / maximum_value;
-
-        float increment_i = i + 0.01;
-        float x2 = (increment_i * cos(increment_i)) / maximum_value;
-        float y2 = (-increment_i * sin(increment_i)) / maximum_value;
-
-        bufferLine(x1, y1, x2, y2);
-        addColors(i, maximum_value);
+        primitiveSink->line(x1, y1, x2, y2);
+        return;
     }
-}
 
+    vertices.push_back(x1);
+    vertices.push_back(y1);
 
-/**
- * ================================================================================================
- *
- * The following code section targets part three of the assignment
- *
- * ================================================================================================
- */
+    vertices.push_back(x2);
+    vertices.push_back(y2);
+}
 
 /**
- * @brief getLeftTriangle
- * @param oldTriangle
- * @return Given the oldTriangle, it will return the leftTriangle
+ * @brief getNextSquare
+ * @param oldSquare
+ * @return given oldSquare/oldDiamond, this function will return the nested square or the nested diamond inside it
  */
-Triangle getLeftTriangle(Triangle oldTriangle)
+template <typename Real>
+constexpr SquareOf<Real> getNextSquare(const SquareOf<Real> &oldSquare)
 {
-    Triangle leftTriangle;
-    leftTriangle.leftLine.startPoint.x = oldTriangle.leftLine.startPoint.x;
-    leftTriangle.leftLine.startPoint.y = oldTriangle.leftLine.startPoint.y;
-    leftTriangle.leftLine.endPoint.x = (oldTriangle.leftLine.startPoint.x + oldTriangle.leftLine.endPoint.x)/2;
-    leftTriangle.leftLine.endPoint.y = (oldTriangle.leftLine.startPoint.y + oldTriangle.leftLine.endPoint.y)/2;
-
-    leftTriangle.rightLine.startPoint.x = (oldTriangle.leftLine.startPoint.x + oldTriangle.leftLine.endPoint.x)/2;
-    leftTriangle.rightLine.startPoint.y = (oldTriangle.leftLine.startPoint.y + oldTriangle.leftLine.endPoint.y)/2;
-    leftTriangle.rightLine.endPoint.x = (oldTriangle.LowerLine.startPoint.x + oldTriangle.LowerLine.endPoint.x)/2;
-    leftTriangle.rightLine.endPoint.y = (oldTriangle.LowerLine.startPoint.y + oldTriangle.LowerLine.endPoint.y)/2;
+    // the corners of the nested shape are the midpoints of the old edges
+    SquareOf<Real> nextSquare = {};
+    for(int i = 0; i < 4; i++)
+        nextSquare.corners[i] = midpoint(oldSquare.corners[i], oldSquare.corners[(i + 1) % 4]);
 
-    leftTriangle.LowerLine.startPoint.x = (oldTriangle.LowerLine.startPoint.x + oldTriangle.LowerLine.endPoint.x)/2;
-    leftTriangle.LowerLine.startPoint.y = (oldTriangle.LowerLine.startPoint.y + oldTriangle.LowerLine.endPoint.y)/2;
-    leftTriangle.LowerLine.endPoint.x = oldTriangle.leftLine.startPoint.x;
-    leftTriangle.LowerLine.endPoint.y = oldTriangle.leftLine.startPoint.y;
-
-    return leftTriangle;
+    return nextSquare;
 }
 
 /**
- * @brief getUpperTriangle
- * @param oldTriangle
- * @return Given the oldTriangle, it will return the upperTriangle
+ * @brief getBaseSquare
+ * @return the outermost square of part one, which is also the carpet of part four
  */
-Triangle getUpperTriangle(Triangle oldTriangle)
+constexpr Square getBaseSquare()
 {
-    Triangle upperTriangle;
-
-    upperTriangle.leftLine.startPoint.x = (oldTriangle.leftLine.startPoint.x + oldTriangle.leftLine.endPoint.x)/2;
-    upperTriangle.leftLine.startPoint.y = (oldTriangle.leftLine.startPoint.y + oldTriangle.leftLine.endPoint.y)/2;
-    upperTriangle.leftLine.endPoint.x = oldTriangle.leftLine.endPoint.x;
-    upperTriangle.leftLine.endPoint.y = oldTriangle.leftLine.endPoint.y;
-
-    upperTriangle.rightLine.startPoint.x = oldTriangle.rightLine.startPoint.x;
-    upperTriangle.rightLine.startPoint.y = oldTriangle.rightLine.startPoint.y;
-    upperTriangle.rightLine.endPoint.x = (oldTriangle.rightLine.startPoint.x + oldTriangle.rightLine.endPoint.x)/2;
-    upperTriangle.rightLine.endPoint.y = (oldTriangle.rightLine.startPoint.y + oldTriangle.rightLine.endPoint.y)/2;
-
-    upperTriangle.LowerLine.startPoint.x = (oldTriangle.rightLine.startPoint.x + oldTriangle.rightLine.endPoint.x)/2;
-    upperTriangle.LowerLine.startPoint.y = (oldTriangle.rightLine.startPoint.y + oldTriangle.rightLine.endPoint.y)/2;
-    upperTriangle.LowerLine.endPoint.x = (oldTriangle.leftLine.startPoint.x + oldTriangle.leftLine.endPoint.x)/2;
-    upperTriangle.LowerLine.endPoint.y = (oldTriangle.leftLine.startPoint.y + oldTriangle.leftLine.endPoint.y)/2;
-
-    return upperTriangle;
+    //Construct the points for the base square
+    return getSquare(Point{ -0.9f, -0.9f }, Point{ -0.9f, 0.9f }, Point{ 0.9f, 0.9f }, Point{ 0.9f, -0.9f });
 }
 
+// colour steps of the nested squares, a square of level i has (i + 1) * 0.1
+constexpr float SQUARE_COLOUR_STEP = 0.1;
+
 /**
- * @brief getRightTriangle
- * @param oldTriangle
- * @return Given the oldTriangle, it will return the rightTriangle
+ * Policy of part one for subdivide(), every piece is a square drawn with the
+ * diamond inside it, and its one child is the square inside that diamond.
  */
-Triangle getRightTriangle(Triangle oldTriangle)
+struct NestedSquaresFractal
 {
-    Triangle rightTriangle;
+    typedef Square Shape;
 
-    rightTriangle.leftLine.startPoint.x = (oldTriangle.LowerLine.startPoint.x + oldTriangle.LowerLine.endPoint.x)/2;
-    rightTriangle.leftLine.startPoint.y = (oldTriangle.LowerLine.startPoint.y + oldTriangle.LowerLine.endPoint.y)/2;
-    rightTriangle.leftLine.endPoint.x = (oldTriangle.rightLine.startPoint.x + oldTriangle.rightLine.endPoint.x)/2;
-    rightTriangle.leftLine.endPoint.y = (oldTriangle.rightLine.startPoint.y + oldTriangle.rightLine.endPoint.y)/2;
+    // index of the square, counted from the outermost one
+    typedef int Branch;
 
-    rightTriangle.rightLine.startPoint.x = (oldTriangle.rightLine.startPoint.x + oldTriangle.rightLine.endPoint.x)/2;
-    rightTriangle.rightLine.startPoint.y = (oldTriangle.rightLine.startPoint.y + oldTriangle.rightLine.endPoint.y)/2;
-    rightTriangle.rightLine.endPoint.x = oldTriangle.rightLine.endPoint.x;
-    rightTriangle.rightLine.endPoint.y = oldTriangle.rightLine.endPoint.y;
+    static const int CHILDREN = 1;
+    static const bool EMIT_EVERY_LEVEL = true;
 
-    rightTriangle.LowerLine.startPoint.x = oldTriangle.rightLine.endPoint.x;
-    rightTriangle.LowerLine.startPoint.y = oldTriangle.rightLine.endPoint.y;
-    rightTriangle.LowerLine.endPoint.x = (oldTriangle.LowerLine.startPoint.x + oldTriangle.LowerLine.endPoint.x)/2;
-    rightTriangle.LowerLine.endPoint.y = (oldTriangle.LowerLine.startPoint.y + oldTriangle.LowerLine.endPoint.y)/2;
-
-    return rightTriangle;
-}
+    template <typename Shape>
+    static constexpr Shape child(const Shape &sqr, int)
+    {
+        return getNextSquare(getNextSquare(sqr));
+    }
 
-void displayTriangle(Triangle triangle)
-{
-    vertices.push_back(triangle.leftLine.startPoint.x);
-    vertices.push_back(triangle.leftLine.startPoint.y);
+    static constexpr int branch(int index, int)
+    {
+        return index + 1;
+    }
 
-    vertices.push_back(triangle.rightLine.startPoint.x);
-    vertices.push_back(triangle.rightLine.startPoint.y);
+    template <typename Shape, typename Sink>
+    static constexpr void outline(const Shape &sqr, float r, float g, float b, Sink &sink)
+    {
+        for(int i = 0; i < 4; i++)
+            sink.line(sqr.corners[i], sqr.corners[(i + 1) % 4], r, g, b);
+    }
+
+    // squares get brighter grey and diamonds darker blue towards the middle
+    template <typename Shape, typename Sink>
+    constexpr void emit(const Shape &sqr, int index, Sink &sink)
+    {
+        float Dcolor = ((float)index * SQUARE_COLOUR_STEP) + SQUARE_COLOUR_STEP;
+        outline(sqr, Dcolor, Dcolor, Dcolor, sink);
+
+        float diamond = 1 - Dcolor - 0.01;
+        outline(getNextSquare(sqr), 0.001f, 0.001f, diamond, sink);
+    }
+
+    // the colour only depends on the index, so culled squares change nothing
+    constexpr void skip(int, int)
+    {}
+};
+
+// levels of part one baked into the binary, deeper levels are generated whole
+const int SQUARE_TABLE_LEVELS = 8;
+
+/**
+ * Lines of the first SQUARE_TABLE_LEVELS levels of part one, generated by the
+ * compiler with the same policy as renderSquaresAndDiamonds(). Every level adds
+ * one square and one diamond of four lines each, so level n is the first
+ * 16 * n vertices of the table.
+ */
+struct SquareTable
+{
+    float positions[SQUARE_TABLE_LEVELS * 16 * 2];
+    float colours[SQUARE_TABLE_LEVELS * 16 * 3];
+
+    constexpr SquareTable() : positions(), colours()
+    {
+        NestedSquaresFractal squares = {};
+        ArraySink sink = { positions, colours };
+        subdivide(squares, getBaseSquare(), 0, SQUARE_TABLE_LEVELS - 1, sink);
+    }
+};
+
+constexpr SquareTable squareTable;
+
+/**
+ * @brief bufferTableLines
+ * Appends lines stored two vertices at a time, with a colour per vertex,
+ * straight to the global arrays, or one by one to the primitive sink.
+ */
+void bufferTableLines(const float *positions, const float *colours, size_t lines)
+{
+    if(primitiveSink)
+    {
+        for(size_t i = 0; i < lines; i++)
+        {
+            primitiveSink->line(positions[i * 4], positions[i * 4 + 1], positions[i * 4 + 2], positions[i * 4 + 3]);
+            primitiveSink->colour(colours[i * 6], colours[i * 6 + 1], colours[i * 6 + 2]);
+        }
+        return;
+    }
+
+    vertices.insert(vertices.end(), positions, positions + lines * 4);
+    if(GENERATE_COLOURS)
+        colors.insert(colors.end(), colours, colours + lines * 6);
+}
+
+void renderSquaresAndDiamonds(int level)
+{
+    // the shallow levels come straight from the table
+    if(level <= SQUARE_TABLE_LEVELS)
+    {
+        bufferTableLines(squareTable.positions, squareTable.colours, max(level, 0) * 8);
+        return;
+    }
+
+    NestedSquaresFractal squares = {};
+    generateFractal(squares, getBaseSquare(), 0, level - 1, (uint64_t)level * 8, 2);
+}
+
+// the window draws the whole of part one as instances of one unit square,
+// renderSquaresAndDiamonds() is only needed by the zoomed view, the dashboard
+// and the exports
+struct MySquares
+{
+    // OpenGL names for the unit square and its vertex array object
+    MyShader shader;
+    GLuint  squareBuffer;
+    GLuint  vertexArray;
+
+    MySquares() : squareBuffer(0), vertexArray(0)
+    {}
+};
+
+// create the unit square and its vertex array, returning true if successful
+bool InitializeSquares(MySquares *squares)
+{
+    if (!InitializeProgram(&squares->shader, "vertex_squares.glsl", "fragment.glsl"))
+        return false;
+
+    const GLuint VERTEX_INDEX = 0;
+
+    // in the corner order of getBaseSquare(), drawn as a line loop
+    const float square[] = { -1.f, -1.f,  -1.f, 1.f,  1.f, 1.f,  1.f, -1.f };
+
+    glGenBuffers(1, &squares->squareBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, squares->squareBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(square), square, GL_STATIC_DRAW);
+
+    glGenVertexArrays(1, &squares->vertexArray);
+    glBindVertexArray(squares->vertexArray);
+    glVertexAttribPointer(VERTEX_INDEX, 2, GL_FLOAT, GL_FALSE, 0, 0);
+    glEnableVertexAttribArray(VERTEX_INDEX);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+
+    return !CheckGLErrors();
+}
+
+// draws a square and a diamond for every level of part one, a new level is a
+// new instance count with nothing generated or uploaded
+void RenderSquares(MySquares *squares)
+{
+    glUseProgram(squares->shader.program);
+    glUniform1i(glGetUniformLocation(squares->shader.program, "ColourScheme"), COLOUR_SCHEME);
+    glUniform1f(glGetUniformLocation(squares->shader.program, "ColourExtent"), PART_ONE_LEVELS);
+
+    glBindVertexArray(squares->vertexArray);
+    glDrawArraysInstanced(GL_LINE_LOOP, 0, 4, 2 * PART_ONE_LEVELS);
+    glBindVertexArray(0);
+    glUseProgram(0);
+}
+
+// deallocate square-related objects
+void DestroySquares(MySquares *squares)
+{
+    glBindVertexArray(0);
+    glDeleteVertexArrays(1, &squares->vertexArray);
+    glDeleteBuffers(1, &squares->squareBuffer);
+    DestroyShaders(&squares->shader);
+}
+
+
+
+/**
+ * ================================================================================================
+ *
+ * The following code section targets part two of the assignment
+ *
+ * ================================================================================================
+ */
+
+void addColors(float i, float maximum_value)
+{
+    if(primitiveSink)
+    {
+        primitiveSink->colour(0.f, 0.f, 1 * (i/maximum_value));
+        return;
+    }
+    if(!GENERATE_COLOURS)
+        return;
+
+    colors.push_back(0.f);
+    colors.push_back(0.f);
+    colors.push_back(1 * (i/maximum_value));
+
+    colors.push_back(0.f);
+    colors.push_back(0.f);
+    colors.push_back(1 * (i/maximum_value));
+}
+
+/**
+ * @brief spiralSegmentCount
+ * @param rotationNumbers
+ * @return the exact number of lines of the spiral, one every 0.01 of the
+ * parameter up to 2 pi per rotation
+ */
+uint64_t spiralSegmentCount(int rotationNumbers)
+{
+    return (uint64_t)ceil(rotationNumbers * 2 * M_PI / 0.01);
+}
+
+void doPartTwo(int rotationNumbers)
+{
+    float maximum_value = rotationNumbers * 2 * M_PI;
+
+    // stepping by index keeps the count exact and the points those of the
+    // vertex shader, a float sum would drift
+    uint64_t segments = spiralSegmentCount(rotationNumbers);
+    for (uint64_t segment = 0; segment < segments; segment++)
+    {
+        float i = segment * 0.01f;
+        float x1 = (i * cos(i)) / maximum_value;
+        float y1 = (-i * sin(i)) / maximum_value;
+
+        float increment_i = i + 0.01;
+        float x2 = (increment_i * cos(increment_i)) / maximum_value;
+        float y2 = (-increment_i * sin(increment_i)) / maximum_value;
+
+        bufferLine(x1, y1, x2, y2);
+        addColors(i, maximum_value);
+    }
+}
+
+// the window draws the spiral from the vertex index alone, doPartTwo() is only
+// needed by the dashboard and the exports
+struct MySpiral
+{
+    // the shader computes every vertex, the vertex array has no attributes
+    MyShader shader;
+    GLuint  vertexArray;
+
+    MySpiral() : vertexArray(0)
+    {}
+};
+
+// create the attribute-less vertex array, returning true if successful
+bool InitializeSpiral(MySpiral *spiral)
+{
+    if (!InitializeProgram(&spiral->shader, "vertex_spiral.glsl", "fragment.glsl"))
+        return false;
+
+    // core profiles draw nothing without a vertex array bound, even an empty one
+    glGenVertexArrays(1, &spiral->vertexArray);
+
+    return !CheckGLErrors();
+}
+
+// draws the spiral of part two as one line strip, a new level is a new uniform
+// and vertex count with nothing generated or uploaded
+void RenderSpiral(MySpiral *spiral)
+{
+    float maximum_value = PART_TWO_LEVELS * 2 * M_PI;
+
+    // a vertex at each end of the lines of doPartTwo()
+    GLsizei count = (GLsizei)spiralSegmentCount(PART_TWO_LEVELS) + 1;
+
+    glUseProgram(spiral->shader.program);
+    glUniform1f(glGetUniformLocation(spiral->shader.program, "SpiralExtent"), maximum_value);
+    glUniform1i(glGetUniformLocation(spiral->shader.program, "ColourScheme"), COLOUR_SCHEME);
+
+    glBindVertexArray(spiral->vertexArray);
+    glDrawArrays(GL_LINE_STRIP, 0, count);
+    glBindVertexArray(0);
+    glUseProgram(0);
+}
+
+// deallocate spiral-related objects
+void DestroySpiral(MySpiral *spiral)
+{
+    glBindVertexArray(0);
+    glDeleteVertexArrays(1, &spiral->vertexArray);
+    DestroyShaders(&spiral->shader);
+}
+
+
+/**
+ * ================================================================================================
+ *
+ * The following code section targets part three of the assignment
+ *
+ * ================================================================================================
+ */
+
+/**
+ * @brief getLeftTriangle
+ * @param oldTriangle
+ * @return Given the oldTriangle, it will return the leftTriangle
+ */
+template <typename Real>
+constexpr TriangleOf<Real> getLeftTriangle(const TriangleOf<Real> &oldTriangle)
+{
+    TriangleOf<Real> leftTriangle = {};
+    leftTriangle.left = oldTriangle.left;
+    leftTriangle.top = midpoint(oldTriangle.left, oldTriangle.top);
+    leftTriangle.right = midpoint(oldTriangle.right, oldTriangle.left);
+
+    return leftTriangle;
+}
+
+/**
+ * @brief getUpperTriangle
+ * @param oldTriangle
+ * @return Given the oldTriangle, it will return the upperTriangle
+ */
+template <typename Real>
+constexpr TriangleOf<Real> getUpperTriangle(const TriangleOf<Real> &oldTriangle)
+{
+    TriangleOf<Real> upperTriangle = {};
+    upperTriangle.left = midpoint(oldTriangle.left, oldTriangle.top);
+    upperTriangle.top = oldTriangle.top;
+    upperTriangle.right = midpoint(oldTriangle.top, oldTriangle.right);
+
+    return upperTriangle;
+}
+
+/**
+ * @brief getRightTriangle
+ * @param oldTriangle
+ * @return Given the oldTriangle, it will return the rightTriangle
+ */
+template <typename Real>
+constexpr TriangleOf<Real> getRightTriangle(const TriangleOf<Real> &oldTriangle)
+{
+    TriangleOf<Real> rightTriangle = {};
+    rightTriangle.left = midpoint(oldTriangle.right, oldTriangle.left);
+    rightTriangle.top = midpoint(oldTriangle.top, oldTriangle.right);
+    rightTriangle.right = oldTriangle.right;
+
+    return rightTriangle;
+}
+
+// deepest level of part three, its leaves are the last ones that can be
+// counted and indexed in 64 bits and the zoomed view cannot show any deeper
+const int SIERPINSKI_MAX_LEVEL = 41;
+
+/**
+ * @brief sierpinskiLeafCount
+ * @param level
+ * @return number of triangles at the given level, 3^(level - 1), saturated
+ * at the largest 64-bit count for levels deeper than SIERPINSKI_MAX_LEVEL
+ */
+uint64_t sierpinskiLeafCount(int level)
+{
+    uint64_t count = 1;
+    for (int i = 1; i < level; i++)
+        count = (count > UINT64_MAX / 3) ? UINT64_MAX : count * 3;
+    return count;
+}
+
+// the base triangle has no third of its own yet
+const int SIERPINSKI_BASE = -1;
+
+/**
+ * Policy of part three for subdivide(). The left third of the triangle is red,
+ * the upper third blue and the right third green, every triangle of a third a
+ * little brighter than the one before it.
+ */
+struct SierpinskiFractal
+{
+    typedef Triangle Shape;
+
+    // colour channel of the third a triangle lies in
+    typedef int Branch;
+
+    static const int CHILDREN = 3;
+    static const bool EMIT_EVERY_LEVEL = false;
+
+    // brightness reached so far in each channel, red, green and blue
+    float rgb[3];
+
+    template <typename Shape>
+    static constexpr Shape child(const Shape &triangle, int i)
+    {
+        return (i == 0) ? getLeftTriangle(triangle) : (i == 1) ? getUpperTriangle(triangle)
+                                                               : getRightTriangle(triangle);
+    }
+
+    static constexpr int branch(int channel, int i)
+    {
+        return (channel != SIERPINSKI_BASE) ? channel : (i == 0) ? 0 : (i == 1) ? 2 : 1;
+    }
+
+    template <typename Shape, typename Sink>
+    constexpr void emit(const Shape &triangle, int channel, Sink &sink)
+    {
+        if(channel == SIERPINSKI_BASE)
+        {
+            sink.triangle(triangle, 0.41f, 0.41f, 0.41f);
+            return;
+        }
+
+        float colour[3] = { 0.f, 0.f, 0.f };
+        colour[channel] = rgb[channel] += 0.009f;
+        sink.triangle(triangle, colour[0], colour[1], colour[2]);
+    }
+
+    // brightens the channel by the triangles it would have had, in one step
+    constexpr void skip(int channel, int depth)
+    {
+        if(channel == SIERPINSKI_BASE)
+            return;
+
+        float leaves = 1;
+        for(int i = 0; i < depth; i++)
+            leaves *= 3;
+        rgb[channel] += 0.009f * leaves;
+    }
+};
+
+float nextRColor = 0.4f;
+float nextGColor = 0.4f;
+float nextBColor = 0.4f;
+
+/**
+ * @brief getBaseTriangle
+ * @return the triangle of level one, which all levels subdivide
+ */
+constexpr Triangle getBaseTriangle()
+{
+    return Triangle{ Point{ -0.5f, -0.5f }, Point{ 0.f, 0.5f }, Point{ 0.5f, -0.5f } };
+}
+
+// levels of part three baked into the binary, deeper levels are generated whole
+const int SIERPINSKI_TABLE_LEVELS = 7;
+
+/**
+ * @brief sierpinskiTableOffset
+ * @return the number of triangles stored for the levels before the given one
+ */
+constexpr int sierpinskiTableOffset(int level)
+{
+    int offset = 0;
+    for(int count = 1; level > 1; level--, count *= 3)
+        offset += count;
+    return offset;
+}
+
+/**
+ * Triangles of every level up to SIERPINSKI_TABLE_LEVELS, generated by the
+ * compiler with the same policy as drawSierpinskiTriangle(), one level after
+ * the other.
+ */
+struct SierpinskiTable
+{
+    // three corners of two floats per triangle
+    float positions[sierpinskiTableOffset(SIERPINSKI_TABLE_LEVELS + 1) * 6];
+
+    // one colour per vertex, three per triangle
+    float colours[sierpinskiTableOffset(SIERPINSKI_TABLE_LEVELS + 1) * 9];
+
+    // the red, green and blue accumulators after each level, when they start from 0.4
+    float finalColours[SIERPINSKI_TABLE_LEVELS + 1][3];
+
+    constexpr SierpinskiTable() : positions(), colours(), finalColours()
+    {
+        for(int level = 1; level <= SIERPINSKI_TABLE_LEVELS; level++)
+        {
+            int first = sierpinskiTableOffset(level);
+            SierpinskiFractal sierpinski = { { 0.4f, 0.4f, 0.4f } };
+            ArraySink sink = { &positions[first * 6], &colours[first * 9] };
+            subdivide(sierpinski, getBaseTriangle(), SIERPINSKI_BASE, level - 1, sink);
+
+            for(int channel = 0; channel < 3; channel++)
+                finalColours[level][channel] = sierpinski.rgb[channel];
+        }
+    }
+};
+
+constexpr SierpinskiTable sierpinskiTable;
+
+/**
+ * @brief bufferTableTriangles
+ * Appends triangles with a colour per vertex straight to the global arrays,
+ * or one by one to the primitive sink.
+ */
+void bufferTableTriangles(const float *positions, const float *colours, size_t count)
+{
+    if(primitiveSink)
+    {
+        for(size_t i = 0; i < count; i++)
+        {
+            const float *p = positions + i * 6;
+            primitiveSink->triangle(Triangle{ Point{ p[0], p[1] }, Point{ p[2], p[3] }, Point{ p[4], p[5] } });
+            primitiveSink->colour(colours[i * 9], colours[i * 9 + 1], colours[i * 9 + 2]);
+        }
+        return;
+    }
+
+    vertices.insert(vertices.end(), positions, positions + count * 6);
+    colors.insert(colors.end(), colours, colours + count * 9);
+}
+
+// slices of fewer triangles are not worth a thread of their own
+const size_t BUILDER_MIN_SLICE = 1 << 14;
+
+// threads parallelFor() spreads its slices over, set with --threads
+unsigned WORKER_THREADS = max(thread::hardware_concurrency(), 1u);
+
+/**
+ * @brief parallelFor
+ * Calls body(first, last) for contiguous slices of [0, count), one slice per
+ * worker thread, the first of them on the calling thread.
+ */
+template <typename Body>
+void parallelFor(size_t count, size_t minimumSlice, const Body &body)
+{
+    size_t slices = min((size_t)WORKER_THREADS, max(count / minimumSlice, (size_t)1));
+    if(slices == 1)
+    {
+        body((size_t)0, count);
+        return;
+    }
+
+    vector<thread> workers;
+    for(size_t i = 1; i < slices; i++)
+        workers.push_back(thread(body, count * i / slices, count * (i + 1) / slices));
+    body((size_t)0, count / slices);
+    for(size_t i = 0; i < workers.size(); i++)
+        workers[i].join();
+}
+
+/**
+ * @brief transformTriangles
+ * Writes the triangles of source, scaled and then moved by (dx, dy), to
+ * target. The loop is plain enough for the compiler to turn into SIMD
+ * instructions from -O2 on, as the readme builds it.
+ */
+void transformTriangles(const float *source, float *target, size_t triangles, float scale, float dx, float dy)
+{
+    const float offset[6] = { dx, dy, dx, dy, dx, dy };
+    for(size_t i = 0; i < triangles; i++)
+        for(int j = 0; j < 6; j++)
+            target[i * 6 + j] = scale * source[i * 6 + j] + offset[j];
+}
+
+/**
+ * @brief buildSierpinski
+ * @param level deeper than the table
+ * @param thirds 3 for the whole triangle, 1 for its left third only
+ * Appends the triangles of the level to the global arrays without recursing.
+ * Every level is three halved copies of the one before it, so the level is
+ * made of copies of the deepest level of the table, each halved once per
+ * level below it and moved by the thirds it lies in. Every triangle is written
+ * exactly once, and the copies are spread over the hardware threads.
+ */
+void buildSierpinski(int level, int thirds)
+{
+    size_t firstPosition = vertices.size();
+    size_t firstColour = colors.size();
+    size_t third = sierpinskiLeafCount(level - 1);
+    vertices.resize(firstPosition + third * thirds * 6);
+    if(GENERATE_COLOURS)
+        colors.resize(firstColour + third * thirds * 9);
+
+    // how far halving the triangle moves it into each of its thirds
+    const Triangle base = getBaseTriangle();
+    float dx[3], dy[3];
+    for(int i = 0; i < 3; i++)
+    {
+        Triangle child = SierpinskiFractal::child(base, i);
+        dx[i] = child.left.x - 0.5f * base.left.x;
+        dy[i] = child.left.y - 0.5f * base.left.y;
+    }
+
+    const float *table = &sierpinskiTable.positions[sierpinskiTableOffset(SIERPINSKI_TABLE_LEVELS) * 6];
+    size_t blockSize = sierpinskiLeafCount(SIERPINSKI_TABLE_LEVELS);
+    int halvings = level - SIERPINSKI_TABLE_LEVELS;
+    size_t blocks = third * thirds / blockSize;
+    float scale = ldexpf(1.f, -halvings);
+
+    float *positions = &vertices[firstPosition];
+    parallelFor(blocks, max(BUILDER_MIN_SLICE / blockSize, (size_t)1), [=](size_t first, size_t last)
+    {
+        for(size_t block = first; block < last; block++)
+        {
+            // the base 3 digits of the block are the thirds it lies in, the
+            // most significant one for the first halving
+            size_t digits = block;
+            float x = 0.f, y = 0.f;
+            for(int i = halvings - 1; i >= 0; i--, digits /= 3)
+            {
+                x += ldexpf(dx[digits % 3], -i);
+                y += ldexpf(dy[digits % 3], -i);
+            }
+            transformTriangles(table, positions + block * blockSize * 6, blockSize, scale, x, y);
+        }
+    });
+
+    if(!GENERATE_COLOURS)
+        return;
+
+    // every triangle of a third is 0.009 brighter than the one before it in
+    // the channel of the third, a serial sum whose value at the start of each
+    // slice is worked out up front, the accumulators of every channel are
+    // assumed to start alike
+    size_t slices = (third + BUILDER_MIN_SLICE - 1) / BUILDER_MIN_SLICE;
+    vector<float> sliceStart(slices);
+    float brightness = nextRColor;
+    for(size_t i = 0; i < third; i++)
+    {
+        if(i % BUILDER_MIN_SLICE == 0)
+            sliceStart[i / BUILDER_MIN_SLICE] = brightness;
+        brightness += 0.009f;
+    }
+    nextRColor = nextGColor = nextBColor = brightness;
+
+    float *colours = &colors[firstColour];
+    const float *starts = sliceStart.data();
+    parallelFor(slices, 1, [=](size_t first, size_t last)
+    {
+        for(size_t slice = first; slice < last; slice++)
+            for(int t = 0; t < thirds; t++)
+            {
+                int channel = SierpinskiFractal::branch(SIERPINSKI_BASE, t);
+                float value = starts[slice];
+                size_t end = min((slice + 1) * BUILDER_MIN_SLICE, third);
+                for(size_t i = slice * BUILDER_MIN_SLICE; i < end; i++)
+                {
+                    value += 0.009f;
+                    float rgb[3] = { 0.f, 0.f, 0.f };
+                    rgb[channel] = value;
+
+                    float *colour = colours + (t * third + i) * 9;
+                    for(int j = 0; j < 9; j++)
+                        colour[j] = rgb[j % 3];
+                }
+            }
+    });
+}
+
+void drawSierpinskiTriangle(int level)
+{
+    // shallow levels are copied from the table, assuming the colour
+    // accumulators start from their usual 0.4
+    if(level <= SIERPINSKI_TABLE_LEVELS)
+    {
+        int first = sierpinskiTableOffset(level);
+        bufferTableTriangles(&sierpinskiTable.positions[first * 6], &sierpinskiTable.colours[first * 9],
+                             sierpinskiTableOffset(level + 1) - first);
+        nextRColor = sierpinskiTable.finalColours[level][0];
+        nextGColor = sierpinskiTable.finalColours[level][1];
+        nextBColor = sierpinskiTable.finalColours[level][2];
+        return;
+    }
+
+    if(!primitiveSink)
+    {
+        buildSierpinski(level, 3);
+        return;
+    }
+
+    // an export streams its triangles one at a time instead
+    SierpinskiFractal sierpinski = { { nextRColor, nextGColor, nextBColor } };
+    generateFractal(sierpinski, getBaseTriangle(), SIERPINSKI_BASE, level - 1, sierpinskiLeafCount(level), 3);
+    nextRColor = sierpinski.rgb[0];
+    nextGColor = sierpinski.rgb[1];
+    nextBColor = sierpinski.rgb[2];
+}
+
+/**
+ * @brief drawSierpinskiThird
+ * @param level at least 2
+ * The left third of drawSierpinskiTriangle(level), which are also its first
+ * triangles. The other two thirds are the same triangles moved and tinted, see
+ * InitializeGeometry(), so the window draws this one three times instead.
+ */
+void drawSierpinskiThird(int level)
+{
+    if(level <= SIERPINSKI_TABLE_LEVELS)
+    {
+        int first = sierpinskiTableOffset(level);
+        bufferTableTriangles(&sierpinskiTable.positions[first * 6], &sierpinskiTable.colours[first * 9],
+                             sierpinskiLeafCount(level - 1));
+        nextRColor = nextGColor = nextBColor = sierpinskiTable.finalColours[level][0];
+        return;
+    }
+
+    if(!primitiveSink)
+    {
+        buildSierpinski(level, 1);
+        return;
+    }
+
+    SierpinskiFractal sierpinski = { { nextRColor, nextGColor, nextBColor } };
+    generateFractal(sierpinski, getLeftTriangle(getBaseTriangle()), SierpinskiFractal::branch(SIERPINSKI_BASE, 0),
+                    level - 2, sierpinskiLeafCount(level - 1), 3);
+    nextRColor = nextGColor = nextBColor = sierpinski.rgb[0];
+}
+
+/**
+ * @brief verifySierpinskiBuilder
+ * @param level deeper than the table
+ * @return true if buildSierpinski() writes exactly the floats of the
+ * recursive generator at this level, both whole and its left third
+ */
+bool verifySierpinskiBuilder(int level)
+{
+    bool match = true;
+    for(int thirds = 3; thirds >= 1; thirds -= 2)
+    {
+        // the recursive generator first, as the exports still use it
+        vertices.clear();
+        colors.clear();
+        SierpinskiFractal sierpinski = { { 0.4f, 0.4f, 0.4f } };
+        if(thirds == 3)
+            generateFractal(sierpinski, getBaseTriangle(), SIERPINSKI_BASE, level - 1, sierpinskiLeafCount(level), 3);
+        else
+            generateFractal(sierpinski, getLeftTriangle(getBaseTriangle()), SierpinskiFractal::branch(SIERPINSKI_BASE, 0),
+                            level - 2, sierpinskiLeafCount(level - 1), 3);
+        FloatBuffer recursiveVertices, recursiveColours;
+        recursiveVertices.swap(vertices);
+        recursiveColours.swap(colors);
+
+        nextRColor = nextGColor = nextBColor = 0.4f;
+        buildSierpinski(level, thirds);
+
+        bool same = vertices.size() == recursiveVertices.size() && colors.size() == recursiveColours.size()
+                    && memcmp(vertices.data(), recursiveVertices.data(), vertices.size() * sizeof(float)) == 0
+                    && memcmp(colors.data(), recursiveColours.data(), colors.size() * sizeof(float)) == 0
+                    && nextRColor == sierpinski.rgb[0];
+        cout << "Sierpinski builder level " << level << (thirds == 3 ? "" : " left third") << ": "
+             << vertices.size() / 2 << " vertices on " << WORKER_THREADS << " thread(s)"
+             << (same ? " [PASS]" : " [FAIL]") << endl;
+        match = match && same;
+    }
+
+    vertices.clear();
+    colors.clear();
+    nextRColor = nextGColor = nextBColor = 0.4f;
+    return match;
+}
+
+
+/**
+ * ================================================================================================
+ *
+ * The following code section targets the camera-relative deep zoom of parts one and three
+ *
+ * ================================================================================================
+ */
+
+// the window shows the world around the centre, VIEW_ZOOM window half-widths
+// per world unit, so the whole part is visible at zoom one
+double VIEW_CENTER_X = 0.0;
+double VIEW_CENTER_Y = 0.0;
+double VIEW_ZOOM = 1.0;
+
+// doubles resolve about 1e-16 of the world, so deeper zooms would jitter again
+const double VIEW_MAX_ZOOM = 1e12;
+
+// pieces no wider than this in window units are rebased to floats relative to
+// the camera and handed to the usual float engine
+const double VIEW_REBASE_SIZE = 2.0;
+
+// further levels a rebased piece is subdivided, which takes a piece the size
+// of the window down to single pixels, anything finer is not visible
+const int VIEW_DETAIL_LEVELS = 9;
+
+/**
+ * @brief ViewIsZoomed
+ * @return true if parts one and three are drawn through the camera instead of
+ * straight from their world coordinates
+ */
+bool ViewIsZoomed()
+{
+    return VIEW_ZOOM != 1.0 || VIEW_CENTER_X != 0.0 || VIEW_CENTER_Y != 0.0;
+}
+
+// sets the camera, keeping the zoom within what doubles resolve, at zoom one
+// the whole part is in view and the camera snaps back to the origin
+void setView(double centerX, double centerY, double zoom)
+{
+    VIEW_ZOOM = min(max(zoom, 1.0), VIEW_MAX_ZOOM);
+    VIEW_CENTER_X = (VIEW_ZOOM == 1.0) ? 0.0 : centerX;
+    VIEW_CENTER_Y = (VIEW_ZOOM == 1.0) ? 0.0 : centerY;
+}
+
+/**
+ * @brief zoomView
+ * Scales the zoom by the factor while keeping the point under the given
+ * window position (in window units, -1 to 1) in place.
+ */
+void zoomView(double factor, double windowX, double windowY)
+{
+    double worldX = VIEW_CENTER_X + windowX / VIEW_ZOOM;
+    double worldY = VIEW_CENTER_Y + windowY / VIEW_ZOOM;
+    double zoom = min(max(VIEW_ZOOM * factor, 1.0), VIEW_MAX_ZOOM);
+    setView(worldX - windowX / zoom, worldY - windowY / zoom, zoom);
+}
+
+// position of a world point in window units, still in double precision
+PrecisePoint viewPoint(const PrecisePoint &p)
+{
+    return PrecisePoint{ (p.x - VIEW_CENTER_X) * VIEW_ZOOM, (p.y - VIEW_CENTER_Y) * VIEW_ZOOM };
+}
+
+Point rebasePoint(const PrecisePoint &p)
+{
+    PrecisePoint view = viewPoint(p);
+    return Point{ (float)view.x, (float)view.y };
+}
+
+Triangle rebase(const PreciseTriangle &triangle)
+{
+    return Triangle{ rebasePoint(triangle.left), rebasePoint(triangle.top), rebasePoint(triangle.right) };
+}
+
+Square rebase(const PreciseSquare &sqr)
+{
+    Square rebased = {};
+    for(int i = 0; i < 4; i++)
+        rebased.corners[i] = rebasePoint(sqr.corners[i]);
+    return rebased;
+}
+
+PreciseTriangle widen(const Triangle &triangle)
+{
+    return PreciseTriangle{ PrecisePoint{ triangle.left.x, triangle.left.y },
+                            PrecisePoint{ triangle.top.x, triangle.top.y },
+                            PrecisePoint{ triangle.right.x, triangle.right.y } };
+}
+
+PreciseSquare widen(const Square &sqr)
+{
+    PreciseSquare widened = {};
+    for(int i = 0; i < 4; i++)
+        widened.corners[i] = PrecisePoint{ sqr.corners[i].x, sqr.corners[i].y };
+    return widened;
+}
+
+/**
+ * @brief viewBounds
+ * Stores the smallest and largest x and y of the corners in window units.
+ */
+void viewBounds(const PrecisePoint *corners, int count, double bounds[4])
+{
+    bounds[0] = bounds[1] = INFINITY;
+    bounds[2] = bounds[3] = -INFINITY;
+    for(int i = 0; i < count; i++)
+    {
+        PrecisePoint view = viewPoint(corners[i]);
+        bounds[0] = min(bounds[0], view.x);
+        bounds[1] = min(bounds[1], view.y);
+        bounds[2] = max(bounds[2], view.x);
+        bounds[3] = max(bounds[3], view.y);
+    }
+}
+
+void viewBounds(const PreciseTriangle &triangle, double bounds[4])
+{
+    PrecisePoint corners[3] = { triangle.left, triangle.top, triangle.right };
+    viewBounds(corners, 3, bounds);
+}
+
+void viewBounds(const PreciseSquare &sqr, double bounds[4])
+{
+    viewBounds(sqr.corners, 4, bounds);
+}
+
+/**
+ * Receives the pieces still larger than the window in double precision and
+ * clips them to the window before they become floats, so edges crossing the
+ * window are exact however far away their corners are.
+ */
+template <typename Sink>
+struct ClippingSink
+{
+    Sink *sink;
+
+    void line(const PrecisePoint &start, const PrecisePoint &end, float r, float g, float b)
+    {
+        // Liang-Barsky, the line runs from t = 0 at the start to t = 1 at the end
+        PrecisePoint from = viewPoint(start);
+        PrecisePoint to = viewPoint(end);
+        double dx = to.x - from.x;
+        double dy = to.y - from.y;
+        double p[4] = { -dx, dx, -dy, dy };
+        double q[4] = { from.x + 1, 1 - from.x, from.y + 1, 1 - from.y };
+
+        double enter = 0, leave = 1;
+        for(int i = 0; i < 4; i++)
+        {
+            if(p[i] == 0)
+            {
+                if(q[i] < 0)
+                    enter = 2;
+                continue;
+            }
+            double t = q[i] / p[i];
+            if(p[i] < 0)
+                enter = max(enter, t);
+            else
+                leave = min(leave, t);
+        }
+
+        // a line outside the window still takes its place as an empty line
+        // off screen, the shader colours part one by the index of the line
+        if(enter > leave)
+        {
+            Point outside = { -2.f, -2.f };
+            sink->line(outside, outside, r, g, b);
+            return;
+        }
+
+        Point clippedStart = { (float)(from.x + enter * dx), (float)(from.y + enter * dy) };
+        Point clippedEnd = { (float)(from.x + leave * dx), (float)(from.y + leave * dy) };
+        sink->line(clippedStart, clippedEnd, r, g, b);
+    }
+
+    void triangle(const PreciseTriangle &triangle, float r, float g, float b)
+    {
+        // Sutherland-Hodgman against the four window edges, the clipped
+        // polygon has at most seven corners
+        PrecisePoint polygon[8] = { viewPoint(triangle.left), viewPoint(triangle.top), viewPoint(triangle.right) };
+        int count = 3;
+
+        for(int edge = 0; edge < 4 && count > 0; edge++)
+        {
+            int axis = edge / 2;
+            double side = (edge % 2 == 0) ? -1 : 1;
+
+            PrecisePoint input[8];
+            copy(polygon, polygon + count, input);
+            int inputCount = count;
+            count = 0;
+
+            for(int i = 0; i < inputCount; i++)
+            {
+                const PrecisePoint &current = input[i];
+                const PrecisePoint &next = input[(i + 1) % inputCount];
+                double a = side * ((axis == 0) ? current.x : current.y);
+                double b = side * ((axis == 0) ? next.x : next.y);
+
+                if(a <= 1)
+                    polygon[count++] = current;
+                if((a <= 1) != (b <= 1))
+                {
+                    double t = (1 - a) / (b - a);
+                    polygon[count++] = PrecisePoint{ current.x + t * (next.x - current.x),
+                                                     current.y + t * (next.y - current.y) };
+                }
+            }
+        }
+
+        for(int i = 1; i + 1 < count; i++)
+        {
+            Triangle fan = { Point{ (float)polygon[0].x, (float)polygon[0].y },
+                             Point{ (float)polygon[i].x, (float)polygon[i].y },
+                             Point{ (float)polygon[i + 1].x, (float)polygon[i + 1].y } };
+            sink->triangle(fan, r, g, b);
+        }
+    }
+};
+
+/**
+ * @brief subdivideInView
+ * Runs the policy on a double precision shape in world coordinates. Pieces
+ * outside the window are culled, and the first pieces small enough are
+ * rebased to floats relative to the camera and finished by subdivide(), so the
+ * GPU keeps 32-bit vertices at any zoom. Work stays bounded by what is visible
+ * however high the level is.
+ */
+template <typename Fractal, typename Shape, typename Sink>
+void subdivideInView(Fractal &fractal, const Shape &shape, typename Fractal::Branch branch, int depth, Sink &sink)
+{
+    double bounds[4];
+    viewBounds(shape, bounds);
+    if(bounds[0] > 1 || bounds[1] > 1 || bounds[2] < -1 || bounds[3] < -1)
+    {
+        fractal.skip(branch, depth);
+        return;
+    }
+
+    if(max(bounds[2] - bounds[0], bounds[3] - bounds[1]) <= VIEW_REBASE_SIZE)
+    {
+        subdivide(fractal, rebase(shape), branch, min(depth, VIEW_DETAIL_LEVELS), sink);
+        return;
+    }
+
+    ClippingSink<Sink> clipping = { &sink };
+    if(Fractal::EMIT_EVERY_LEVEL || depth == 0)
+        fractal.emit(shape, branch, clipping);
+    if(depth == 0)
+        return;
+
+    for(int i = 0; i < Fractal::CHILDREN; i++)
+        subdivideInView(fractal, Fractal::child(shape, i), Fractal::branch(branch, i), depth - 1, sink);
+}
+
+// part one at the given level as seen by the camera
+void renderSquaresAndDiamondsInView(int level)
+{
+    NestedSquaresFractal squares = {};
+    AppendSink sink;
+    subdivideInView(squares, widen(getBaseSquare()), 0, level - 1, sink);
+}
+
+// part three at the given level as seen by the camera
+void drawSierpinskiTriangleInView(int level)
+{
+    SierpinskiFractal sierpinski = { { nextRColor, nextGColor, nextBColor } };
+    AppendSink sink;
+    subdivideInView(sierpinski, widen(getBaseTriangle()), SIERPINSKI_BASE, level - 1, sink);
+    nextRColor = sierpinski.rgb[0];
+    nextGColor = sierpinski.rgb[1];
+    nextBColor = sierpinski.rgb[2];
+}
+
+
+/**
+ * ================================================================================================
+ *
+ * The following code section targets picking the leaf of part three under the cursor
+ *
+ * ================================================================================================
+ */
+
+// last cursor position in window units, -1 to 1, once the cursor has moved
+// over the window
+bool   hoverActive = false;
+double hoverCursorX = 0;
+double hoverCursorY = 0;
+
+struct SierpinskiPick
+{
+    // false when the point is outside the triangle or in one of its holes
+    bool            hit;
+
+    // position of the leaf among those drawSierpinskiTriangle() emits, its
+    // base 3 digits are the thirds it lies in from the top level down, 0 for
+    // the left, 1 the upper and 2 the right third, and it fits 64 bits up to
+    // level 41
+    uint64_t        index;
+
+    // corners of the leaf in world coordinates
+    PreciseTriangle bounds;
+};
+
+/**
+ * @brief pickSierpinski
+ * Finds the leaf of the level under a world position without generating any
+ * geometry. The barycentric coordinates of the point in the base triangle
+ * tell which third it lies in, and doubling them gives its coordinates in
+ * that third, so every level costs a few comparisons and the walk is
+ * O(level). Doubling is exact in binary, so the walk adds no rounding of
+ * its own.
+ * @param x world position
+ * @param y world position
+ * @param level
+ * @return the leaf under the point, if any
+ */
+SierpinskiPick pickSierpinski(double x, double y, int level)
+{
+    SierpinskiPick pick = {};
+    PreciseTriangle triangle = widen(getBaseTriangle());
+
+    // weights of the left, top and right corners, which sum to one
+    const PrecisePoint &a = triangle.left, &b = triangle.top, &c = triangle.right;
+    double area = (b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y);
+    double top = ((x - a.x) * (c.y - a.y) - (c.x - a.x) * (y - a.y)) / area;
+    double right = ((b.x - a.x) * (y - a.y) - (x - a.x) * (b.y - a.y)) / area;
+    double left = 1.0 - top - right;
+    if (left < 0 || top < 0 || right < 0)
+        return pick;
+
+    for (int i = 1; i < level; i++)
+    {
+        // a third holds the points within half of its corner, the points
+        // close to none of the corners are in the hole in the middle
+        int third;
+        if (left >= 0.5)
+            third = 0;
+        else if (top >= 0.5)
+            third = 1;
+        else if (right >= 0.5)
+            third = 2;
+        else
+            return pick;
+
+        left = (third == 0) ? 2 * left - 1 : 2 * left;
+        top = (third == 1) ? 2 * top - 1 : 2 * top;
+        right = (third == 2) ? 2 * right - 1 : 2 * right;
+
+        pick.index = pick.index * 3 + third;
+        triangle = SierpinskiFractal::child(triangle, third);
+    }
+
+    pick.hit = true;
+    pick.bounds = triangle;
+    return pick;
+}
+
+// the leaf clipped to the window is a polygon of up to seven corners, drawn
+// as a fan of up to five triangles
+const int HIGHLIGHT_MAX_TRIANGLES = 5;
+
+struct MyHighlight
+{
+    // corners of the leaf under the cursor, in window coordinates
+    GLuint  vertexBuffer;
+    GLuint  vertexArray;
+
+    // triangles currently in the buffer
+    Triangle shown[HIGHLIGHT_MAX_TRIANGLES];
+    int     shownCount;
+
+    MyHighlight() : vertexBuffer(0), vertexArray(0), shown(), shownCount(0)
+    {}
+};
+
+// collects the fan that ClippingSink makes of the highlighted leaf
+struct HighlightSink
+{
+    Triangle    *triangles;
+    int         count;
+
+    void triangle(const Triangle &triangle, float, float, float)
+    {
+        triangles[count++] = triangle;
+    }
+};
+
+// create the buffer of the highlight, returning true if successful
+bool InitializeHighlight(MyHighlight *highlight)
+{
+    const GLuint VERTEX_INDEX = 0;
+
+    glGenBuffers(1, &highlight->vertexBuffer);
+    glGenVertexArrays(1, &highlight->vertexArray);
+
+    glBindVertexArray(highlight->vertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, highlight->vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(highlight->shown), highlight->shown, GL_DYNAMIC_DRAW);
+    glVertexAttribPointer(VERTEX_INDEX, 2, GL_FLOAT, GL_FALSE, 0, 0);
+    glEnableVertexAttribArray(VERTEX_INDEX);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    return !CheckGLErrors();
+}
+
+/**
+ * @brief RenderHighlight
+ * Fills the leaf of part three under the cursor in yellow at the current level and
+ * view, picked again every frame since that costs the same at any level. A
+ * leaf smaller than a pixel still shows as a dot. The shader program of the
+ * main geometry is expected to be bound already.
+ */
+void RenderHighlight(MyHighlight *highlight, MyShader *shader)
+{
+    if (!hoverActive)
+        return;
+
+    SierpinskiPick pick = pickSierpinski(VIEW_CENTER_X + hoverCursorX / VIEW_ZOOM,
+                                         VIEW_CENTER_Y + hoverCursorY / VIEW_ZOOM,
+                                         max(PART_THREE_LEVELS, 1));
+    if (!pick.hit)
+        return;
+
+    // a leaf much larger than the window has corners too far away for
+    // floats, so it is clipped to the window in double precision first
+    Triangle corners[HIGHLIGHT_MAX_TRIANGLES];
+    HighlightSink fan = { corners, 0 };
+    ClippingSink<HighlightSink> clipping = { &fan };
+    clipping.triangle(pick.bounds, 0.f, 0.f, 0.f);
+    if (fan.count == 0)
+        return;
+
+    // at most 120 bytes, and only when the leaf or the view changes
+    if (fan.count != highlight->shownCount
+        || memcmp(corners, highlight->shown, fan.count * sizeof(Triangle)) != 0)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, highlight->vertexBuffer);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, fan.count * sizeof(Triangle), corners);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        copy(corners, corners + fan.count, highlight->shown);
+        highlight->shownCount = fan.count;
+    }
+
+    // yellow in either colour scheme, the heat palette would turn it white
+    glUniform1i(glGetUniformLocation(shader->program, "ColourRule"), COLOUR_FROM_ATTRIBUTE);
+    glUniform1i(glGetUniformLocation(shader->program, "ColourScheme"), 0);
+    glBindVertexArray(highlight->vertexArray);
+    glVertexAttrib3f(1, 1.f, 0.85f, 0.f);
+    glDrawArrays(GL_TRIANGLES, 0, 3 * fan.count);
+    glDrawArrays(GL_POINTS, 0, 1);
+    glBindVertexArray(0);
+    glUniform1i(glGetUniformLocation(shader->program, "ColourScheme"), COLOUR_SCHEME);
+}
+
+// deallocate highlight-related objects
+void DestroyHighlight(MyHighlight *highlight)
+{
+    glBindVertexArray(0);
+    glDeleteVertexArrays(1, &highlight->vertexArray);
+    glDeleteBuffers(1, &highlight->vertexBuffer);
+}
+
+/**
+ * ================================================================================================
+ *
+ * The following code section targets part four, the Sierpinski carpet
+ *
+ * ================================================================================================
+ */
+
+// deeper levels have squares smaller than a pixel of our window
+const int CARPET_MAX_LEVEL = 7;
+
+struct MyCarpet
+{
+    // shader drawing one unit quad per carpet square
+    MyShader shader;
+
+    // the unit quad, the per-instance squares and their vertex array object
+    GLuint  quadBuffer;
+    GLuint  instanceBuffer;
+    GLuint  vertexArray;
+    GLsizei instanceCount;
+
+    // level currently held in the instance buffer, zero if none
+    int     level;
+
+    MyCarpet() : quadBuffer(0), instanceBuffer(0), vertexArray(0), instanceCount(0), level(0)
+    {}
+};
+
+/**
+ * @brief carpetSquareCount
+ * @param level
+ * @return the exact number of squares at the given level, 8^level
+ */
+uint64_t carpetSquareCount(int level)
+{
+    return (uint64_t)1 << (3 * level);
+}
+
+/**
+ * @brief getCarpetSquare
+ * @param sqr
+ * @param row 0 to 2 from the bottom
+ * @param column 0 to 2 from the left
+ * @return the square in the given cell of a 3x3 grid laid over sqr
+ */
+constexpr Square getCarpetSquare(const Square &sqr, int row, int column)
+{
+    // corners run lower left, upper left, upper right, lower right
+    float width = (sqr.corners[3].x - sqr.corners[0].x) / 3;
+    float height = (sqr.corners[1].y - sqr.corners[0].y) / 3;
+
+    Point one = { sqr.corners[0].x + column * width, sqr.corners[0].y + row * height };
+    Point two = { one.x, one.y + height };
+    Point three = { one.x + width, two.y };
+    Point four = { three.x, one.y };
+
+    return getSquare(one, two, three, four);
+}
+
+/**
+ * Policy of part four for subdivide(), every square keeps the eight outer
+ * cells of a 3x3 grid laid over it, the middle one is the hole. The squares
+ * are emitted as instances, their colour comes from the shader.
+ */
+struct CarpetFractal
+{
+    typedef Square Shape;
+
+    // the carpet has no colour rule
+    typedef int Branch;
+
+    static const int CHILDREN = 8;
+    static const bool EMIT_EVERY_LEVEL = false;
+
+    // cells run row by row from the lower left, skipping the middle one
+    static constexpr Square child(const Square &sqr, int i)
+    {
+        int cell = (i < 4) ? i : i + 1;
+        return getCarpetSquare(sqr, cell / 3, cell % 3);
+    }
+
+    static constexpr int branch(int, int)
+    {
+        return 0;
+    }
+
+    template <typename Sink>
+    constexpr void emit(const Square &sqr, int, Sink &sink)
+    {
+        sink.instance(sqr);
+    }
+};
+
+// levels of the carpet baked into the binary, deeper levels are generated whole
+const int CARPET_TABLE_LEVELS = 3;
+
+/**
+ * @brief carpetTableOffset
+ * @return the number of squares stored for the levels before the given one
+ */
+constexpr int carpetTableOffset(int level)
+{
+    int offset = 0;
+    for(int count = 8; level > 1; level--, count *= 8)
+        offset += count;
+    return offset;
+}
+
+/**
+ * Instances of every carpet level up to CARPET_TABLE_LEVELS, generated by the
+ * compiler with the same policy as drawSierpinskiCarpet(), one level after the
+ * other.
+ */
+struct CarpetTable
+{
+    float instances[carpetTableOffset(CARPET_TABLE_LEVELS + 1) * 3];
+
+    constexpr CarpetTable() : instances()
+    {
+        for(int level = 1; level <= CARPET_TABLE_LEVELS; level++)
+        {
+            CarpetFractal carpet = {};
+            ArraySink sink = { &instances[carpetTableOffset(level) * 3], NULL };
+            subdivide(carpet, getBaseSquare(), 0, level, sink);
+        }
+    }
+};
+
+constexpr CarpetTable carpetTable;
+
+/**
+ * @brief drawSierpinskiCarpet
+ * @param level
+ * @param instances sized here to exactly 3 * 8^level floats
+ */
+void drawSierpinskiCarpet(int level, vector<float> &instances)
+{
+    instances.resize(3 * carpetSquareCount(level));
+
+    if(level <= CARPET_TABLE_LEVELS)
+    {
+        const float *first = &carpetTable.instances[carpetTableOffset(level) * 3];
+        copy(first, first + instances.size(), instances.begin());
+        return;
+    }
+
+    CarpetFractal carpet = {};
+    ArraySink sink = { &instances[0], NULL };
+    subdivide(carpet, getBaseSquare(), 0, level, sink);
+}
+
+// create the unit quad and instanced vertex array, returning true if successful
+bool InitializeCarpet(MyCarpet *carpet)
+{
+    if (!InitializeProgram(&carpet->shader, "vertex_carpet.glsl", "fragment.glsl"))
+        return false;
+
+    const GLuint VERTEX_INDEX = 0;
+    const GLuint COLOUR_INDEX = 1;
+    const GLuint INSTANCE_INDEX = 2;
+
+    // drawn as a triangle fan
+    const float quad[] = { 0.f, 0.f,  0.f, 1.f,  1.f, 1.f,  1.f, 0.f };
+
+    glGenBuffers(1, &carpet->quadBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, carpet->quadBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+
+    glGenBuffers(1, &carpet->instanceBuffer);
+    glGenVertexArrays(1, &carpet->vertexArray);
+    glBindVertexArray(carpet->vertexArray);
+
+    glBindBuffer(GL_ARRAY_BUFFER, carpet->quadBuffer);
+    glVertexAttribPointer(VERTEX_INDEX, 2, GL_FLOAT, GL_FALSE, 0, 0);
+    glEnableVertexAttribArray(VERTEX_INDEX);
+
+    // every square has the same colour, so the colour is a constant
+    // attribute value instead of an array
+    glDisableVertexAttribArray(COLOUR_INDEX);
+
+    glBindBuffer(GL_ARRAY_BUFFER, carpet->instanceBuffer);
+    glVertexAttribPointer(INSTANCE_INDEX, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    glVertexAttribDivisor(INSTANCE_INDEX, 1);
+    glEnableVertexAttribArray(INSTANCE_INDEX);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+
+    return !CheckGLErrors();
+}
+
+// draws the carpet at the level of part four, regenerating it on level changes
+void RenderCarpet(MyCarpet *carpet)
+{
+    if(carpet->level != PART_FOUR_LEVELS)
+    {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+        AllocationScope allocations("carpet");
+        vector<float> instances;
+        const float *data = NULL;
+        size_t count = carpetSquareCount(PART_FOUR_LEVELS);
+
+        // levels in the table are uploaded straight from it
+        if(PART_FOUR_LEVELS <= CARPET_TABLE_LEVELS)
+            data = &carpetTable.instances[carpetTableOffset(PART_FOUR_LEVELS) * 3];
+        else
+        {
+            drawSierpinskiCarpet(PART_FOUR_LEVELS, instances);
+            data = &instances[0];
+        }
+        chrono::duration<double, milli> generation = chrono::steady_clock::now() - start;
+        renderStats.generationMilliseconds += generation.count();
+
+        glBindBuffer(GL_ARRAY_BUFFER, carpet->instanceBuffer);
+        UploadBufferData(GL_ARRAY_BUFFER, sizeof(float) * 3 * count, data, GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        carpet->instanceCount = count;
+        carpet->level = PART_FOUR_LEVELS;
+        noteMemoryUse(instances.size() * sizeof(float), sizeof(float) * 3 * count);
+
+        chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+        cout << "Carpet level " << carpet->level << ": " << carpet->instanceCount
+             << " squares in " << elapsed.count() << " ms" << endl;
+    }
+
+    glUseProgram(carpet->shader.program);
+    glBindVertexArray(carpet->vertexArray);
+    glVertexAttrib3f(1, 0.35f, 0.1f, 0.45f);
+    glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, 4, carpet->instanceCount);
+    glBindVertexArray(0);
+    glUseProgram(0);
+}
+
+// deallocate carpet-related objects
+void DestroyCarpet(MyCarpet *carpet)
+{
+    glBindVertexArray(0);
+    glDeleteVertexArrays(1, &carpet->vertexArray);
+    glDeleteBuffers(1, &carpet->quadBuffer);
+    glDeleteBuffers(1, &carpet->instanceBuffer);
+    DestroyShaders(&carpet->shader);
+}
+
+/**
+ * ================================================================================================
+ *
+ * The following code section targets parts five and six, the Sierpinski tetrahedron and the
+ * Menger sponge in 3D
+ *
+ * ================================================================================================
+ */
+
+// the lattice coordinates of the deepest levels still fit an unsigned short,
+// and the sponge at level 5 already has 6.5 million visible faces
+const int TETRAHEDRON_MAX_LEVEL = 8;
+const int MENGER_MAX_LEVEL = 5;
+
+// orbit camera around the solids, dragged with the left mouse button and
+// zoomed with the scroll wheel
+float CAMERA_YAW = 0.6f;
+float CAMERA_PITCH = 0.45f;
+float CAMERA_DISTANCE = 2.6f;
+
+bool cameraDragging = false;
+double cameraCursorX = 0;
+double cameraCursorY = 0;
+
+struct MySolid
+{
+    // shader lighting the faces from their screen-space derivatives
+    MyShader shader;
+
+    // shared lattice vertices, triangle indices and their vertex array object
+    GLuint  vertexBuffer;
+    GLuint  elementBuffer;
+    GLuint  vertexArray;
+    GLsizei elementCount;
+
+    // part and level currently held in the buffers, zero if none
+    int     part;
+    int     level;
+
+    // number of lattice cells along each side, used to centre the solid
+    int     latticeSize;
+
+    MySolid() : vertexBuffer(0), elementBuffer(0), vertexArray(0), elementCount(0),
+        part(0), level(0), latticeSize(1)
+    {}
+};
+
+// lattice point of a solid, the fourth component keeps every vertex 8 bytes
+struct LatticeVertex
+{
+    GLushort x, y, z, pad;
+};
+
+/**
+ * @brief addLatticeVertex
+ * @return the index of the new vertex
+ */
+int addLatticeVertex(vector<LatticeVertex> &lattice, int x, int y, int z)
+{
+    LatticeVertex vertex = { (GLushort)x, (GLushort)y, (GLushort)z, 0 };
+    lattice.push_back(vertex);
+    return lattice.size() - 1;
+}
+
+/**
+ * @brief addLatticeMidpoint
+ * @return the index of a new vertex halfway between vertices a and b
+ */
+int addLatticeMidpoint(vector<LatticeVertex> &lattice, int a, int b)
+{
+    return addLatticeVertex(lattice, (lattice[a].x + lattice[b].x) / 2,
+                            (lattice[a].y + lattice[b].y) / 2, (lattice[a].z + lattice[b].z) / 2);
+}
+
+/**
+ * @brief buildTetrahedron
+ * Splits the tetrahedron with corners a, b, c and d into four half-size
+ * tetrahedra at its corners, which meet only at the edge midpoints. The
+ * midpoints are created once here and handed to the children, so no vertex
+ * is ever stored twice. Corners are ordered so that the faces below wind
+ * counter-clockwise seen from outside.
+ */
+void buildTetrahedron(vector<LatticeVertex> &lattice, int level, int a, int b, int c, int d)
+{
+    if(level == 0)
+    {
+        const int faces[] = { a, c, b,  a, b, d,  a, d, c,  b, c, d };
+        elements.insert(elements.end(), faces, faces + 12);
+        return;
+    }
+
+    int ab = addLatticeMidpoint(lattice, a, b);
+    int ac = addLatticeMidpoint(lattice, a, c);
+    int ad = addLatticeMidpoint(lattice, a, d);
+    int bc = addLatticeMidpoint(lattice, b, c);
+    int bd = addLatticeMidpoint(lattice, b, d);
+    int cd = addLatticeMidpoint(lattice, c, d);
+
+    buildTetrahedron(lattice, level - 1, a, ab, ac, ad);
+    buildTetrahedron(lattice, level - 1, ab, b, bc, bd);
+    buildTetrahedron(lattice, level - 1, ac, bc, c, cd);
+    buildTetrahedron(lattice, level - 1, ad, bd, cd, d);
+}
+
+/**
+ * @brief drawSierpinskiTetrahedron
+ * @param level number of subdivisions, giving 4^level tetrahedra
+ * @param lattice sized here to exactly 2 * 4^level + 2 vertices
+ * @return the number of lattice cells along each side
+ */
+int drawSierpinskiTetrahedron(int level, vector<LatticeVertex> &lattice)
+{
+    // every other corner of a cube makes a regular tetrahedron, and with a
+    // side of 2^level all midpoints land on the integer lattice
+    int size = 1 << level;
+    uint64_t tetrahedra = (uint64_t)1 << (2 * level);
+
+    lattice.clear();
+    lattice.reserve(2 * tetrahedra + 2);
+    elements.clear();
+    elements.reserve(12 * tetrahedra);
+
+    int a = addLatticeVertex(lattice, 0, 0, 0);
+    int b = addLatticeVertex(lattice, size, 0, size);
+    int c = addLatticeVertex(lattice, size, size, 0);
+    int d = addLatticeVertex(lattice, 0, size, size);
+    buildTetrahedron(lattice, level, a, b, c, d);
+
+    return size;
+}
+
+/**
+ * @brief mengerFaceCount
+ * @param level
+ * @return the exact number of visible unit faces of the sponge, 2*20^level + 4*8^level
+ */
+uint64_t mengerFaceCount(int level)
+{
+    uint64_t faces = 2, sides = 4;
+    for(int i = 0; i < level; i++)
+    {
+        faces *= 20;
+        sides *= 8;
+    }
+    return faces + sides;
+}
+
+/**
+ * @brief drawMengerSponge
+ * Walks the 3^level lattice one slab of cells at a time. A cell is removed
+ * when two of its base 3 coordinates have a 1 in the same digit, and a face
+ * of a remaining cell is kept only when the neighbour on the other side is
+ * removed or outside the sponge, so the faces two cubes share never reach
+ * the GPU. Vertices are looked up in the index tables of the two lattice
+ * planes bounding the slab, so each is stored once.
+ *
+ * @param level number of subdivisions, giving 20^level cubes
+ * @param lattice filled with the vertices of the visible faces
+ * @return the number of lattice cells along each side
+ */
+int drawMengerSponge(int level, vector<LatticeVertex> &lattice)
+{
+    int size = 1;
+    for(int i = 0; i < level; i++)
+        size *= 3;
+
+    // bit i is set when base 3 digit i of the coordinate is a 1
+    vector<int> middleDigits(size);
+    for(int coordinate = 0; coordinate < size; coordinate++)
+        for(int rest = coordinate, digit = 0; rest > 0; rest /= 3, digit++)
+            if(rest % 3 == 1)
+                middleDigits[coordinate] |= 1 << digit;
+
+    struct Cells
+    {
+        const vector<int> &digits;
+        int size;
+        bool solid(int x, int y, int z) const
+        {
+            if(x < 0 || y < 0 || z < 0 || x >= size || y >= size || z >= size)
+                return false;
+            int mx = digits[x], my = digits[y], mz = digits[z];
+            return ((mx & my) | (my & mz) | (mx & mz)) == 0;
+        }
+    } cells = { middleDigits, size };
+
+    // corners of the face towards each neighbour, counter-clockwise from outside
+    static const int NEIGHBOURS[6][3] = {
+        { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+    static const int FACES[6][4][3] = {
+        { { 1, 0, 0 }, { 1, 1, 0 }, { 1, 1, 1 }, { 1, 0, 1 } },
+        { { 0, 0, 0 }, { 0, 0, 1 }, { 0, 1, 1 }, { 0, 1, 0 } },
+        { { 0, 1, 0 }, { 0, 1, 1 }, { 1, 1, 1 }, { 1, 1, 0 } },
+        { { 0, 0, 0 }, { 1, 0, 0 }, { 1, 0, 1 }, { 0, 0, 1 } },
+        { { 0, 0, 1 }, { 1, 0, 1 }, { 1, 1, 1 }, { 0, 1, 1 } },
+        { { 0, 0, 0 }, { 0, 1, 0 }, { 1, 1, 0 }, { 1, 0, 0 } } };
+
+    uint64_t faces = mengerFaceCount(level);
+    lattice.clear();
+    lattice.reserve(faces);
+    elements.clear();
+    elements.reserve(6 * faces);
+
+    // vertex indices of the lattice planes below and above the current slab
+    int points = size + 1;
+    vector<int> planes[2];
+    planes[0].assign(points * points, -1);
+    planes[1].assign(points * points, -1);
+
+    for(int z = 0; z < size; z++)
+    {
+        for(int y = 0; y < size; y++)
+            for(int x = 0; x < size; x++)
+            {
+                if(!cells.solid(x, y, z))
+                    continue;
+
+                for(int side = 0; side < 6; side++)
+                {
+                    const int *n = NEIGHBOURS[side];
+                    if(cells.solid(x + n[0], y + n[1], z + n[2]))
+                        continue;
+
+                    int corners[4];
+                    for(int i = 0; i < 4; i++)
+                    {
+                        const int *corner = FACES[side][i];
+                        int &index = planes[corner[2]][(y + corner[1]) * points + x + corner[0]];
+                        if(index < 0)
+                            index = addLatticeVertex(lattice, x + corner[0], y + corner[1], z + corner[2]);
+                        corners[i] = index;
+                    }
+
+                    const int quad[] = { corners[0], corners[1], corners[2],
+                                         corners[0], corners[2], corners[3] };
+                    elements.insert(elements.end(), quad, quad + 6);
+                }
+            }
+
+        // the plane above this slab is the plane below the next one
+        planes[0].swap(planes[1]);
+        planes[1].assign(points * points, -1);
+    }
+
+    return size;
+}
+
+/**
+ * @brief multiplyMatrices
+ * Sets result to a * b, all column-major 4x4 matrices.
+ */
+void multiplyMatrices(const float *a, const float *b, float *result)
+{
+    for(int column = 0; column < 4; column++)
+        for(int row = 0; row < 4; row++)
+        {
+            float sum = 0;
+            for(int i = 0; i < 4; i++)
+                sum += a[i * 4 + row] * b[column * 4 + i];
+            result[column * 4 + row] = sum;
+        }
+}
+
+/**
+ * @brief solidModelViewProjection
+ * Builds the matrix taking lattice coordinates of the given size to clip
+ * space, for the orbit camera looking at the centre of the solid.
+ */
+void solidModelViewProjection(int latticeSize, float aspect, float *matrix)
+{
+    // centre the lattice on the origin and scale it into a unit box
+    float scale = 1.0f / latticeSize;
+    float model[16] = { scale, 0, 0, 0,  0, scale, 0, 0,  0, 0, scale, 0,  -0.5f, -0.5f, -0.5f, 1 };
+
+    // rotate by the yaw around y, then by the pitch around x, and push back
+    float cy = cos(CAMERA_YAW), sy = sin(CAMERA_YAW);
+    float cp = cos(CAMERA_PITCH), sp = sin(CAMERA_PITCH);
+    float view[16] = { cy, sp * sy, -cp * sy, 0,
+                       0,  cp,      sp,       0,
+                       sy, -sp * cy, cp * cy, 0,
+                       0,  0,       -CAMERA_DISTANCE, 1 };
+
+    // 45 degree vertical field of view
+    float nearPlane = 0.05f, farPlane = CAMERA_DISTANCE + 2;
+    float focal = 1.0f / tan(M_PI / 8);
+    float projection[16] = { focal / aspect, 0, 0, 0,
+                             0, focal, 0, 0,
+                             0, 0, (farPlane + nearPlane) / (nearPlane - farPlane), -1,
+                             0, 0, 2 * farPlane * nearPlane / (nearPlane - farPlane), 0 };
+
+    float modelView[16];
+    multiplyMatrices(view, model, modelView);
+    multiplyMatrices(projection, modelView, matrix);
+}
+
+// create the lattice vertex array of the solids, returning true if successful
+bool InitializeSolid(MySolid *solid)
+{
+    if (!InitializeProgram(&solid->shader, "vertex_solid.glsl", "fragment_solid.glsl"))
+        return false;
+
+    const GLuint VERTEX_INDEX = 0;
+    const GLuint COLOUR_INDEX = 1;
+
+    glGenBuffers(1, &solid->vertexBuffer);
+    glGenBuffers(1, &solid->elementBuffer);
+    glGenVertexArrays(1, &solid->vertexArray);
+    glBindVertexArray(solid->vertexArray);
+
+    glBindBuffer(GL_ARRAY_BUFFER, solid->vertexBuffer);
+    glVertexAttribPointer(VERTEX_INDEX, 3, GL_UNSIGNED_SHORT, GL_FALSE, sizeof(LatticeVertex), 0);
+    glEnableVertexAttribArray(VERTEX_INDEX);
+
+    // each solid has a single colour, the faces are told apart by their lighting
+    glDisableVertexAttribArray(COLOUR_INDEX);
+
+    // the element buffer binding is part of the vertex array object
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, solid->elementBuffer);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    return !CheckGLErrors();
+}
+
+// draws part five or six, regenerating the mesh when the part or level changes
+void RenderSolid(MySolid *solid)
+{
+    int part = PART_FIVE ? 5 : 6;
+    int level = *partLevels(part);
+
+    if(solid->part != part || solid->level != level)
+    {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+        AllocationScope allocations(part == 5 ? "tetrahedron" : "menger sponge");
+        vector<LatticeVertex> lattice;
+        if(part == 5)
+            solid->latticeSize = drawSierpinskiTetrahedron(level, lattice);
+        else
+            solid->latticeSize = drawMengerSponge(level, lattice);
+        chrono::duration<double, milli> generation = chrono::steady_clock::now() - start;
+        renderStats.generationMilliseconds += generation.count();
+
+        glBindBuffer(GL_ARRAY_BUFFER, solid->vertexBuffer);
+        UploadBufferData(GL_ARRAY_BUFFER, sizeof(LatticeVertex)*lattice.size(), &lattice[0], GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        glBindVertexArray(solid->vertexArray);
+        UploadBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(int)*elements.size(), &elements[0], GL_STATIC_DRAW);
+        glBindVertexArray(0);
+
+        solid->elementCount = elements.size();
+        solid->part = part;
+        solid->level = level;
+
+        uint64_t bytes = sizeof(LatticeVertex) * lattice.size() + sizeof(int) * elements.size();
+        noteMemoryUse(bytes, bytes);
+
+        chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+        cout << (part == 5 ? "Tetrahedron" : "Menger sponge") << " level " << level << ": "
+             << solid->elementCount / 3 << " triangles, " << lattice.size() << " vertices, "
+             << bytes / (1024 * 1024) << " MB in " << elapsed.count() << " ms" << endl;
+
+        // the GPU has its own copy now
+        vector<int>().swap(elements);
+    }
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    float matrix[16];
+    solidModelViewProjection(solid->latticeSize, (float)viewport[2] / max(viewport[3], 1), matrix);
+
+    glClearColor(1.0, 1.0, 1.0, 1.0);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+
+    glUseProgram(solid->shader.program);
+    glUniformMatrix4fv(glGetUniformLocation(solid->shader.program, "ModelViewProjection"), 1, GL_FALSE, matrix);
+    glBindVertexArray(solid->vertexArray);
+    if(part == 5)
+        glVertexAttrib3f(1, 0.2f, 0.45f, 0.7f);
+    else
+        glVertexAttrib3f(1, 0.75f, 0.5f, 0.2f);
+    glDrawElements(GL_TRIANGLES, solid->elementCount, GL_UNSIGNED_INT, 0);
+    glBindVertexArray(0);
+    glUseProgram(0);
+
+    // the 2D parts draw without depth test or culling
+    glDisable(GL_CULL_FACE);
+    glDisable(GL_DEPTH_TEST);
+}
+
+// deallocate solid-related objects
+void DestroySolid(MySolid *solid)
+{
+    glBindVertexArray(0);
+    glDeleteVertexArrays(1, &solid->vertexArray);
+    glDeleteBuffers(1, &solid->vertexBuffer);
+    glDeleteBuffers(1, &solid->elementBuffer);
+    DestroyShaders(&solid->shader);
+}
+
+/**
+ * ================================================================================================
+ *
+ * The following code section targets the memory budget of the scenes
+ *
+ * ================================================================================================
+ */
+
+// set with --host-budget and --gpu-budget, in bytes, a part and level whose
+// geometry would not fit is drawn in chunks or at a lower level instead
+uint64_t HOST_MEMORY_BUDGET = (uint64_t)256 << 20;
+uint64_t GPU_MEMORY_BUDGET = (uint64_t)256 << 20;
+
+// the largest count a single draw call takes
+const uint64_t MAX_DRAW_COUNT = 0x7fffffff;
+
+struct SceneSize
+{
+    // vertices (instances for the carpet) and element indices of the geometry
+    uint64_t vertices;
+    uint64_t indices;
+
+    // the same geometry in bytes, held once on the host and once on the GPU
+    uint64_t bytes;
+};
+
+// a * b, or UINT64_MAX if that does not fit
+uint64_t saturatingMultiply(uint64_t a, uint64_t b)
+{
+    return (a != 0 && b > UINT64_MAX / a) ? UINT64_MAX : a * b;
+}
+
+// a + b, or UINT64_MAX if that does not fit
+uint64_t saturatingAdd(uint64_t a, uint64_t b)
+{
+    return (b > UINT64_MAX - a) ? UINT64_MAX : a + b;
+}
+
+// base^exponent, or UINT64_MAX if that does not fit
+uint64_t saturatingPower(uint64_t base, int exponent)
+{
+    uint64_t power = 1;
+    for (int i = 0; i < exponent && power != UINT64_MAX; i++)
+        power = saturatingMultiply(power, base);
+    return power;
+}
+
+/**
+ * @brief sceneSize
+ * Counts the geometry of a part generated whole on the CPU, as the dashboard,
+ * the mesh cache and the carpet and solid scenes do, without generating it.
+ * Counts too large for 64 bits saturate at UINT64_MAX.
+ * @param part 1 to 6
+ * @param level
+ * @return the exact vertex and index counts and their size in bytes
+ */
+SceneSize sceneSize(int part, int level)
+{
+    SceneSize size = { 0, 0, 0 };
+    uint64_t vertexBytes = 5 * sizeof(float);
+    level = max(level, 1);
+
+    if (part == 1)
+    {
+        // a square and a diamond of four lines each per level
+        size.vertices = 16 * (uint64_t)level;
+    }
+    else if (part == 2)
+    {
+        size.vertices = 2 * spiralSegmentCount(level);
+    }
+    else if (part == 3)
+    {
+        size.vertices = saturatingPower(3, level);
+    }
+    else if (part == 4)
+    {
+        // one offset and scale per square
+        size.vertices = saturatingPower(8, level);
+        vertexBytes = 3 * sizeof(float);
+    }
+    else if (part == 5)
+    {
+        uint64_t tetrahedra = saturatingPower(4, level);
+        size.vertices = saturatingAdd(saturatingMultiply(2, tetrahedra), 2);
+        size.indices = saturatingMultiply(12, tetrahedra);
+        vertexBytes = sizeof(LatticeVertex);
+    }
+    else if (part == 6)
+    {
+        // every unit face is two triangles, and the corners of the visible
+        // faces number (224*20^level + 456*8^level + 384) / 133
+        uint64_t cubes = saturatingPower(20, level), sides = saturatingPower(8, level);
+        uint64_t faces = saturatingAdd(saturatingMultiply(2, cubes), saturatingMultiply(4, sides));
+        uint64_t corners = saturatingAdd(saturatingMultiply(224, cubes), saturatingMultiply(456, sides));
+        size.vertices = saturatingAdd(corners, 384) / 133;
+        size.indices = saturatingMultiply(6, faces);
+        vertexBytes = sizeof(LatticeVertex);
+    }
+
+    size.bytes = saturatingAdd(saturatingMultiply(size.vertices, vertexBytes),
+                               saturatingMultiply(size.indices, sizeof(int)));
+    return size;
+}
+
+// geometry generated on the CPU is held on both sides, so the smaller budget
+// is the one it has to fit
+uint64_t sceneBudget()
+{
+    return min(HOST_MEMORY_BUDGET, GPU_MEMORY_BUDGET);
+}
+
+/**
+ * @brief fitsMemoryBudget
+ * @param size
+ * @param budget in bytes
+ * @return true if the geometry fits the budget and a single draw call
+ */
+bool fitsMemoryBudget(const SceneSize &size, uint64_t budget = sceneBudget())
+{
+    return size.bytes <= budget && size.vertices <= MAX_DRAW_COUNT && size.indices <= MAX_DRAW_COUNT;
+}
+
+/**
+ * @brief levelWithinBudget
+ * Every part grows with its level, so the deepest level that fits is found
+ * by bisection even for absurd levels.
+ * @param part 1 to 6
+ * @param level
+ * @param budget in bytes
+ * @return the given level, or the deepest lower one whose geometry fits the
+ * budget, at least 1
+ */
+int levelWithinBudget(int part, int level, uint64_t budget = sceneBudget())
+{
+    if (fitsMemoryBudget(sceneSize(part, level), budget))
+        return max(level, 1);
+
+    int low = 1, high = level;
+    while (high - low > 1)
+    {
+        int middle = low + (high - low) / 2;
+        if (fitsMemoryBudget(sceneSize(part, middle), budget))
+            low = middle;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+// tells why a scene is drawn at a lower level than the one asked for
+void reportLevelOverBudget(const char *scene, int part, int level, int lowered)
+{
+    SceneSize size = sceneSize(part, level);
+    cout << scene << " level " << level << " needs " << size.vertices << " vertices and "
+         << size.bytes / (1024 * 1024) << " MB, over the memory budget of "
+         << sceneBudget() / (1024 * 1024) << " MB, drawing level " << lowered << " instead" << endl;
+}
+
+/**
+ * ================================================================================================
+ *
+ * The following code section targets the compute shader backend of part three
+ *
+ * ================================================================================================
+ */
+
+// toggled with the G key, only honoured when the context can run compute shaders
+bool COMPUTE_SIERPINSKI = false;
+
+// filled in by InitializeComputeGeometry()
+bool computeShaderSupported = false;
+GLint64 computeMaxStorageBlockSize = 0;
+
+struct MyComputeGeometry
+{
+    // compute program writing the triangles of one level
+    GLuint  program;
+
+    // shader storage buffers, also bound as the vertex arrays for drawing
+    GLuint  positionBuffer;
+    GLuint  colourBuffer;
+    GLuint  vertexArray;
+    GLsizei elementCount;
+
+    // level currently held in the buffers, zero if none
+    int     level;
+
+    MyComputeGeometry() : program(0), positionBuffer(0), colourBuffer(0), vertexArray(0),
+                          elementCount(0), level(0)
+    {}
+};
+
+/**
+ * @brief UseComputeSierpinski
+ * @param level
+ * @return true if part three at this level should be generated on the GPU
+ */
+bool UseComputeSierpinski(int level)
+{
+    // the zoomed camera only generates what it sees, on the CPU
+    if (!COMPUTE_SIERPINSKI || !computeShaderSupported || ViewIsZoomed())
+        return false;
+
+    // the leaf index is a 32-bit uint in the shader, the colour buffer is the
+    // larger of the two storage blocks, and nothing of it is on the host
+    uint64_t leaves = sierpinskiLeafCount(level);
+    return leaves <= 0xffffffffull
+           && leaves * 9 * sizeof(float) <= (uint64_t)computeMaxStorageBlockSize
+           && sceneSize(3, level).bytes <= GPU_MEMORY_BUDGET;
+}
+
+// create the compute program and buffers, returning false (and leaving the
+// CPU generator in charge) if the context has no compute shader support
+bool InitializeComputeGeometry(MyComputeGeometry *compute)
+{
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    bool supported = (major > 4 || (major == 4 && minor >= 3))
+                     || (glfwExtensionSupported("GL_ARB_compute_shader")
+                         && glfwExtensionSupported("GL_ARB_shader_storage_buffer_object"));
+    if (!supported)
+    {
+        cout << "Compute shaders unavailable, part three is generated on the CPU" << endl;
+        return false;
+    }
+
+    // load the compute program, through the binary cache like the others
+    AllocationScope allocations("shaders");
+    string source = LoadSource("sierpinski.comp");
+    if (source.empty()) return false;
+
+    string key = ProgramCacheKey(source, "");
+    compute->program = LoadProgramBinary(key);
+    if (!compute->program)
+    {
+        GLuint shaderObject = CompileShader(GL_COMPUTE_SHADER, source);
+        compute->program = LinkProgram(shaderObject, 0);
+        glDeleteShader(shaderObject);
+        SaveProgramBinary(compute->program, key);
+    }
+
+    GLint status;
+    glGetProgramiv(compute->program, GL_LINK_STATUS, &status);
+    if (status == GL_FALSE) return false;
+
+    glGetInteger64v(GL_MAX_SHADER_STORAGE_BLOCK_SIZE, &computeMaxStorageBlockSize);
+
+    // the storage buffers double as the vertex arrays, using the same
+    // attribute layout as InitializeGeometry()
+    const GLuint VERTEX_INDEX = 0;
+    const GLuint COLOUR_INDEX = 1;
+
+    glGenBuffers(1, &compute->positionBuffer);
+    glGenBuffers(1, &compute->colourBuffer);
+    glGenVertexArrays(1, &compute->vertexArray);
+    glBindVertexArray(compute->vertexArray);
+
+    glBindBuffer(GL_ARRAY_BUFFER, compute->positionBuffer);
+    glVertexAttribPointer(VERTEX_INDEX, 2, GL_FLOAT, GL_FALSE, 0, 0);
+    glEnableVertexAttribArray(VERTEX_INDEX);
+
+    glBindBuffer(GL_ARRAY_BUFFER, compute->colourBuffer);
+    glVertexAttribPointer(COLOUR_INDEX, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    glEnableVertexAttribArray(COLOUR_INDEX);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+
+    computeShaderSupported = !CheckGLErrors();
+    return computeShaderSupported;
+}
+
+// dispatch the compute program to fill the buffers with the given level
+void GenerateSierpinskiOnGPU(MyComputeGeometry *compute, int level)
+{
+    uint64_t leaves = sierpinskiLeafCount(level);
+
+    // (re)allocate storage for the whole level, the contents come from the GPU
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, compute->positionBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, leaves * 6 * sizeof(float), NULL, GL_DYNAMIC_COPY);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, compute->colourBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, leaves * 9 * sizeof(float), NULL, GL_DYNAMIC_COPY);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, compute->positionBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, compute->colourBuffer);
+
+    glUseProgram(compute->program);
+    glUniform1i(glGetUniformLocation(compute->program, "Level"), level);
+    glUniform1ui(glGetUniformLocation(compute->program, "LeafCount"), (GLuint)leaves);
+
+    // split the work into dispatches no larger than the work group count limit
+    const uint64_t LOCAL_SIZE = 64;
+    GLint maxGroups = 0;
+    glGetIntegeri_v(GL_MAX_COMPUTE_WORK_GROUP_COUNT, 0, &maxGroups);
+    uint64_t perDispatch = (uint64_t)maxGroups * LOCAL_SIZE;
+
+    GLint firstLeafLocation = glGetUniformLocation(compute->program, "FirstLeaf");
+    for (uint64_t first = 0; first < leaves; first += perDispatch)
+    {
+        uint64_t count = min(perDispatch, leaves - first);
+        glUniform1ui(firstLeafLocation, (GLuint)first);
+        glDispatchCompute((GLuint)((count + LOCAL_SIZE - 1) / LOCAL_SIZE), 1, 1);
+    }
+
+    // make the shader writes visible to the vertex fetch that follows
+    glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+    glUseProgram(0);
+
+    compute->elementCount = (GLsizei)(leaves * 3);
+    compute->level = level;
+}
+
+// compares the GPU generated level against the CPU generator, returning true
+// if every vertex position and colour matches
+bool VerifySierpinskiOnGPU(MyComputeGeometry *compute, int level)
+{
+    vertices.clear();
+    colors.clear();
+    drawSierpinskiTriangle(level);
+    nextRColor = 0.4f;
+    nextGColor = 0.4f;
+    nextBColor = 0.4f;
+
+    GenerateSierpinskiOnGPU(compute, level);
+
+    vector<float> gpuVertices(vertices.size());
+    vector<float> gpuColors(colors.size());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, compute->positionBuffer);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, gpuVertices.size() * sizeof(float), &gpuVertices[0]);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, compute->colourBuffer);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, gpuColors.size() * sizeof(float), &gpuColors[0]);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    // positions are exact (midpoints only halve), the CPU colours accumulate
+    // rounding error from repeated additions and are compared as displayed,
+    // i.e. clamped to the framebuffer range
+    float positionError = 0.f, colourError = 0.f;
+    for (size_t i = 0; i < vertices.size(); i++)
+        positionError = max(positionError, fabsf(vertices[i] - gpuVertices[i]));
+    for (size_t i = 0; i < colors.size(); i++)
+        colourError = max(colourError, fabsf(min(colors[i], 1.f) - min(gpuColors[i], 1.f)));
+
+    bool match = positionError <= 1e-6f && colourError <= 1e-3f && !CheckGLErrors();
+    cout << "Compute Sierpinski level " << level << ": " << vertices.size() / 2
+         << " vertices, max position error " << positionError
+         << ", max colour error " << colourError
+         << (match ? " [PASS]" : " [FAIL]") << endl;
+
+    vertices.clear();
+    colors.clear();
+    return match;
+}
+
+// deallocate compute-related objects
+void DestroyComputeGeometry(MyComputeGeometry *compute)
+{
+    glBindVertexArray(0);
+    glDeleteVertexArrays(1, &compute->vertexArray);
+    glDeleteBuffers(1, &compute->positionBuffer);
+    glDeleteBuffers(1, &compute->colourBuffer);
+    glDeleteProgram(compute->program);
+}
+
+/**
+ * ================================================================================================
+ *
+ * The following code section targets out-of-core rendering of part three
+ *
+ * ================================================================================================
+ */
+
+// toggled with the O key, always draws part three in chunks
+bool OUT_OF_CORE = false;
+
+// triangles generated, uploaded and drawn at a time
+const uint64_t CHUNK_LEAVES = 1 << 16;
+
+// chunk buffers are recycled round robin, so the GPU can still be drawing
+// one while the next is filled
+const int CHUNK_BUFFERS = 3;
+
+struct MyChunkedGeometry
+{
+    // recycled chunk buffers and their vertex array objects
+    GLuint  vertexBuffers[CHUNK_BUFFERS];
+    GLuint  colourBuffers[CHUNK_BUFFERS];
+    GLuint  vertexArrays[CHUNK_BUFFERS];
+
+    // host staging memory for one chunk
+    vector<float> positions;
+    vector<float> colours;
+
+    MyChunkedGeometry()
+    {
+        for (int i = 0; i < CHUNK_BUFFERS; i++)
+            vertexBuffers[i] = colourBuffers[i] = vertexArrays[i] = 0;
+    }
+};
+
+// walks the leaves of one level in order, keeping the triangle at every depth
+// of the current path so that stepping to the next leaf only recomputes the
+// levels whose digit changed
+struct SierpinskiCursor
+{
+    int         level;
+    uint64_t    leaf;
+    int         digits[SIERPINSKI_MAX_LEVEL];
+    Triangle    path[SIERPINSKI_MAX_LEVEL];
+};
+
+// positions the cursor on the given leaf, digits are most significant first
+void seekSierpinskiCursor(SierpinskiCursor *cursor, int level, uint64_t leaf)
+{
+    cursor->level = level;
+    cursor->leaf = leaf;
+    cursor->path[0] = getBaseTriangle();
+
+    uint64_t scale = sierpinskiLeafCount(level);
+    for (int depth = 0; depth + 1 < level; depth++)
+    {
+        scale /= 3;
+        cursor->digits[depth] = (int)(leaf / scale);
+        leaf %= scale;
+        cursor->path[depth + 1] = SierpinskiFractal::child(cursor->path[depth], cursor->digits[depth]);
+    }
+}
+
+// moves to the next leaf like an odometer, amortized constant time
+void advanceSierpinskiCursor(SierpinskiCursor *cursor)
+{
+    cursor->leaf++;
+    int depth = cursor->level - 2;
+    while (depth >= 0 && cursor->digits[depth] == 2)
+        cursor->digits[depth--] = 0;
+    if (depth < 0) return;
+
+    cursor->digits[depth]++;
+    for (; depth + 1 < cursor->level; depth++)
+        cursor->path[depth + 1] = SierpinskiFractal::child(cursor->path[depth], cursor->digits[depth]);
+}
+
+/**
+ * @brief generateSierpinskiLeaves
+ * Writes count leaves of the level starting at first into the arrays, with
+ * the same positions and colours as drawSierpinskiTriangle().
+ */
+void generateSierpinskiLeaves(int level, uint64_t first, uint64_t count,
+                              float *positions, float *colours)
+{
+    SierpinskiCursor cursor;
+    seekSierpinskiCursor(&cursor, level, first);
+
+    uint64_t perSide = sierpinskiLeafCount(level) / 3;
+    for (uint64_t i = 0; i < count; i++)
+    {
+        const Triangle &leaf = cursor.path[level - 1];
+        float *p = positions + 6*i;
+        p[0] = leaf.left.x;  p[1] = leaf.left.y;
+        p[2] = leaf.top.x;   p[3] = leaf.top.y;
+        p[4] = leaf.right.x; p[5] = leaf.right.y;
+
+        // each third gets its own channel, brightening leaf by leaf
+        float rgb[3] = { 0.41f, 0.41f, 0.41f };
+        if (level > 1)
+        {
+            int side = cursor.digits[0];
+            float shade = 0.4f + 0.009f * (float)(cursor.leaf - side * perSide + 1);
+            int channel = SierpinskiFractal::branch(SIERPINSKI_BASE, side);
+            rgb[0] = rgb[1] = rgb[2] = 0.f;
+            rgb[channel] = shade;
+        }
+        float *c = colours + 9*i;
+        for (int v = 0; v < 9; v++)
+            c[v] = rgb[v % 3];
+
+        advanceSierpinskiCursor(&cursor);
+    }
+}
+
+// deepest level of part three drawn whole, its triangles are under half a
+// pixel even in a 4K window, while every further level triples the work
+const int SIERPINSKI_MAX_DRAWN_LEVEL = 14;
+
+/**
+ * @brief sierpinskiDrawnLevel
+ * @param level of part three
+ * @return the level actually drawn, deeper levels are only told apart from
+ * SIERPINSKI_MAX_DRAWN_LEVEL by zooming in
+ */
+int sierpinskiDrawnLevel(int level)
+{
+    return ViewIsZoomed() ? level : min(level, SIERPINSKI_MAX_DRAWN_LEVEL);
+}
+
+/**
+ * @brief UseOutOfCoreSierpinski
+ * @param level
+ * @return true if part three at this level is drawn chunk by chunk
+ */
+bool UseOutOfCoreSierpinski(int level)
+{
+    // the zoomed camera is bounded by the window instead of the level
+    if (ViewIsZoomed())
+        return false;
+
+    // otherwise levels are held whole while their left third, the size of the
+    // whole level before it, fits the memory budget
+    return OUT_OF_CORE || !fitsMemoryBudget(sceneSize(3, level - 1));
+}
+
+// create the recycled chunk buffers and the staging memory, both sized for
+// one chunk no matter how large a level is drawn
+bool InitializeChunkedGeometry(MyChunkedGeometry *chunked)
+{
+    const GLuint VERTEX_INDEX = 0;
+    const GLuint COLOUR_INDEX = 1;
+
+    glGenBuffers(CHUNK_BUFFERS, chunked->vertexBuffers);
+    glGenBuffers(CHUNK_BUFFERS, chunked->colourBuffers);
+    glGenVertexArrays(CHUNK_BUFFERS, chunked->vertexArrays);
+
+    for (int i = 0; i < CHUNK_BUFFERS; i++)
+    {
+        glBindVertexArray(chunked->vertexArrays[i]);
+
+        glBindBuffer(GL_ARRAY_BUFFER, chunked->vertexBuffers[i]);
+        glBufferData(GL_ARRAY_BUFFER, CHUNK_LEAVES * 6 * sizeof(float), NULL, GL_STREAM_DRAW);
+        glVertexAttribPointer(VERTEX_INDEX, 2, GL_FLOAT, GL_FALSE, 0, 0);
+        glEnableVertexAttribArray(VERTEX_INDEX);
+
+        glBindBuffer(GL_ARRAY_BUFFER, chunked->colourBuffers[i]);
+        glBufferData(GL_ARRAY_BUFFER, CHUNK_LEAVES * 9 * sizeof(float), NULL, GL_STREAM_DRAW);
+        glVertexAttribPointer(COLOUR_INDEX, 3, GL_FLOAT, GL_FALSE, 0, 0);
+        glEnableVertexAttribArray(COLOUR_INDEX);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+
+    chunked->positions.resize(CHUNK_LEAVES * 6);
+    chunked->colours.resize(CHUNK_LEAVES * 9);
+
+    return !CheckGLErrors();
+}
+
+// generate, upload and draw the level one chunk at a time, the shader
+// program is expected to be bound already
+void RenderOutOfCoreSierpinski(MyChunkedGeometry *chunked, int level)
+{
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    uint64_t leaves = sierpinskiLeafCount(level);
+    uint64_t chunks = 0;
+    for (uint64_t first = 0; first < leaves; first += CHUNK_LEAVES, chunks++)
+    {
+        uint64_t count = min(CHUNK_LEAVES, leaves - first);
+        chrono::steady_clock::time_point generationStart = chrono::steady_clock::now();
+        {
+            AllocationScope allocations("out-of-core");
+            generateSierpinskiLeaves(level, first, count, &chunked->positions[0], &chunked->colours[0]);
+        }
+        chrono::duration<double, milli> generation = chrono::steady_clock::now() - generationStart;
+        renderStats.generationMilliseconds += generation.count();
+
+        // orphan the previous storage so we never wait for the GPU to
+        // finish drawing from it
+        int slot = chunks % CHUNK_BUFFERS;
+        glBindBuffer(GL_ARRAY_BUFFER, chunked->vertexBuffers[slot]);
+        glBufferData(GL_ARRAY_BUFFER, CHUNK_LEAVES * 6 * sizeof(float), NULL, GL_STREAM_DRAW);
+        UploadBufferSubData(GL_ARRAY_BUFFER, 0, count * 6 * sizeof(float), &chunked->positions[0]);
+        glBindBuffer(GL_ARRAY_BUFFER, chunked->colourBuffers[slot]);
+        glBufferData(GL_ARRAY_BUFFER, CHUNK_LEAVES * 9 * sizeof(float), NULL, GL_STREAM_DRAW);
+        UploadBufferSubData(GL_ARRAY_BUFFER, 0, count * 9 * sizeof(float), &chunked->colours[0]);
+
+        glBindVertexArray(chunked->vertexArrays[slot]);
+        glDrawArrays(GL_TRIANGLES, 0, (GLsizei)(count * 3));
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glFinish();
+
+    uint64_t chunkBytes = CHUNK_LEAVES * 15 * sizeof(float);
+    noteMemoryUse(chunkBytes, chunkBytes * CHUNK_BUFFERS);
+
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    double chunkMegabytes = chunkBytes / (1024.0 * 1024.0);
+    cout << "Out-of-core level " << level << ": " << leaves << " triangles in " << chunks
+         << " chunks, " << elapsed.count() * 1000.0 << " ms, "
+         << leaves / elapsed.count() / 1e6 << " M triangles/s (host "
+         << chunkMegabytes << " MB, GPU " << chunkMegabytes * CHUNK_BUFFERS << " MB)" << endl;
+}
+
+// deallocate chunk-related objects
+void DestroyChunkedGeometry(MyChunkedGeometry *chunked)
+{
+    glBindVertexArray(0);
+    glDeleteVertexArrays(CHUNK_BUFFERS, chunked->vertexArrays);
+    glDeleteBuffers(CHUNK_BUFFERS, chunked->vertexBuffers);
+    glDeleteBuffers(CHUNK_BUFFERS, chunked->colourBuffers);
+}
+
+/**
+ * ================================================================================================
+ *
+ * The following code section targets the split-screen dashboard of all parts
+ *
+ * ================================================================================================
+ */
+
+// toggled with the D key, draws every part side by side
+bool DASHBOARD = false;
+
+// filled in by InitializeDashboard()
+bool multiDrawIndirectSupported = false;
+
+// set by the key handlers, the dashboard is rebuilt on the next frame
+bool dashboardChanged = true;
+
+// layout of one command in the GL_DRAW_INDIRECT_BUFFER
+struct DrawArraysIndirectCommand
+{
+    GLuint  count;
+    GLuint  instanceCount;
+    GLuint  first;
+    GLuint  baseInstance;
+};
+
+struct MyDashboard
+{
+    // one shared buffer per attribute, suballocated between the parts
+    GLuint  vertexBuffer;
+    GLuint  colourBuffer;
+
+    // per-draw viewport rectangles and the indirect draw commands
+    GLuint  viewportBuffer;
+    GLuint  indirectBuffer;
+    GLuint  vertexArray;
+
+    // shader placing each part in its viewport region
+    MyShader shader;
+
+    // number of commands drawn as lines and as triangles
+    GLsizei lineDraws;
+    GLsizei triangleDraws;
+
+    MyDashboard() : vertexBuffer(0), colourBuffer(0), viewportBuffer(0), indirectBuffer(0),
+                    vertexArray(0), lineDraws(0), triangleDraws(0)
+    {}
+};
+
+// create the dashboard buffers and shader, returning false if the context
+// cannot do multi-draw-indirect
+bool InitializeDashboard(MyDashboard *dashboard)
+{
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    bool supported = (major > 4 || (major == 4 && minor >= 3))
+                     || (glfwExtensionSupported("GL_ARB_multi_draw_indirect")
+                         && glfwExtensionSupported("GL_ARB_base_instance"));
+    if (!supported)
+    {
+        cout << "Multi-draw-indirect unavailable, dashboard disabled" << endl;
+        return false;
+    }
+
+    if (!InitializeProgram(&dashboard->shader, "vertex_dashboard.glsl", "fragment.glsl"))
+        return false;
+
+    // these vertex attribute indices correspond to those specified for the
+    // input variables in the dashboard vertex shader
+    const GLuint VERTEX_INDEX = 0;
+    const GLuint COLOUR_INDEX = 1;
+    const GLuint VIEWPORT_INDEX = 2;
+
+    glGenBuffers(1, &dashboard->vertexBuffer);
+    glGenBuffers(1, &dashboard->colourBuffer);
+    glGenBuffers(1, &dashboard->viewportBuffer);
+    glGenBuffers(1, &dashboard->indirectBuffer);
+
+    // a 2x2 grid, parts one to three fill it left to right, top to bottom
+    const float viewports[] = {
+        -0.5f,  0.5f, 0.5f, 0.5f,
+         0.5f,  0.5f, 0.5f, 0.5f,
+        -0.5f, -0.5f, 0.5f, 0.5f,
+    };
+    glBindBuffer(GL_ARRAY_BUFFER, dashboard->viewportBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(viewports), viewports, GL_STATIC_DRAW);
+
+    glGenVertexArrays(1, &dashboard->vertexArray);
+    glBindVertexArray(dashboard->vertexArray);
+
+    glBindBuffer(GL_ARRAY_BUFFER, dashboard->vertexBuffer);
+    glVertexAttribPointer(VERTEX_INDEX, 2, GL_FLOAT, GL_FALSE, 0, 0);
+    glEnableVertexAttribArray(VERTEX_INDEX);
+
+    glBindBuffer(GL_ARRAY_BUFFER, dashboard->colourBuffer);
+    glVertexAttribPointer(COLOUR_INDEX, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    glEnableVertexAttribArray(COLOUR_INDEX);
+
+    // advance the viewport once per instance, the base instance of each
+    // indirect command picks the rectangle for that part
+    glBindBuffer(GL_ARRAY_BUFFER, dashboard->viewportBuffer);
+    glVertexAttribPointer(VIEWPORT_INDEX, 4, GL_FLOAT, GL_FALSE, 0, 0);
+    glVertexAttribDivisor(VIEWPORT_INDEX, 1);
+    glEnableVertexAttribArray(VIEWPORT_INDEX);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+
+    multiDrawIndirectSupported = !CheckGLErrors();
+    return multiDrawIndirectSupported;
+}
+
+/**
+ * @brief dashboardLevelsWithinBudget
+ * The dashboard holds parts one to three in one buffer, so while they do not
+ * fit the memory budget together the largest of them that can still be
+ * lowered is lowered to what the others leave of it.
+ * @param levels of parts one to three, lowered in place
+ */
+void dashboardLevelsWithinBudget(int levels[3])
+{
+    for (int i = 0; i < 3; i++)
+        levels[i] = levelWithinBudget(i + 1, levels[i]);
+
+    while (true)
+    {
+        uint64_t total = 0, largestBytes = 0;
+        int largest = -1;
+        for (int i = 0; i < 3; i++)
+        {
+            uint64_t bytes = sceneSize(i + 1, levels[i]).bytes;
+            total = saturatingAdd(total, bytes);
+            if (levels[i] > 1 && bytes > largestBytes)
+            {
+                largest = i;
+                largestBytes = bytes;
+            }
+        }
+        if (total <= sceneBudget() || largest < 0)
+            return;
+
+        // the others may not fit together either, then the largest drops to
+        // its first level and the next pass lowers the next largest, every
+        // pass lowers a level so the loop ends
+        uint64_t others = total - largestBytes;
+        uint64_t budget = (others < sceneBudget()) ? sceneBudget() - others : 0;
+        levels[largest] = levelWithinBudget(largest + 1, levels[largest], budget);
+    }
+}
+
+// generate every part at its current level into the shared buffers and
+// record one indirect command per part
+void BuildDashboard(MyDashboard *dashboard)
+{
+    vector<DrawArraysIndirectCommand> commands;
+    DrawArraysIndirectCommand command;
+    command.instanceCount = 1;
+
+    vertices.clear();
+    colors.clear();
+
+    // parts too large to hold together are shown at lower levels
+    int levels[3] = { max(PART_ONE_LEVELS, 1), max(PART_TWO_LEVELS, 1), max(PART_THREE_LEVELS, 1) };
+    dashboardLevelsWithinBudget(levels);
+    static const char *SCENES[] = { "Dashboard part one", "Dashboard part two", "Dashboard part three" };
+    for (int i = 0; i < 3; i++)
+        if (levels[i] != max(*partLevels(i + 1), 1))
+            reportLevelOverBudget(SCENES[i], i + 1, *partLevels(i + 1), levels[i]);
+
+    // line parts first so that they form one contiguous run of commands
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    AllocationScope allocations("dashboard");
+
+    command.first = vertices.size() / 2;
+    renderSquaresAndDiamonds(levels[0]);
+    command.count = vertices.size() / 2 - command.first;
+    command.baseInstance = 0;
+    commands.push_back(command);
+
+    command.first = vertices.size() / 2;
+    doPartTwo(levels[1]);
+    command.count = vertices.size() / 2 - command.first;
+    command.baseInstance = 1;
+    commands.push_back(command);
+
+    command.first = vertices.size() / 2;
+    drawSierpinskiTriangle(levels[2]);
+    nextRColor = 0.4f;
+    nextGColor = 0.4f;
+    nextBColor = 0.4f;
+    command.count = vertices.size() / 2 - command.first;
+    command.baseInstance = 2;
+    commands.push_back(command);
+
+    dashboard->lineDraws = 2;
+    dashboard->triangleDraws = 1;
+
+    chrono::duration<double, milli> generation = chrono::steady_clock::now() - start;
+    renderStats.generationMilliseconds += generation.count();
+
+    uint64_t bytes = sizeof(float) * (vertices.size() + colors.size());
+    noteMemoryUse(bytes, bytes);
+
+    glBindBuffer(GL_ARRAY_BUFFER, dashboard->vertexBuffer);
+    UploadBufferData(GL_ARRAY_BUFFER, sizeof(float)*vertices.size(), &vertices[0], GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, dashboard->colourBuffer);
+    UploadBufferData(GL_ARRAY_BUFFER, sizeof(float)*colors.size(), &colors[0], GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, dashboard->indirectBuffer);
+    UploadBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(DrawArraysIndirectCommand)*commands.size(),
+                 &commands[0], GL_STATIC_DRAW);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+    cout << "Dashboard: " << commands.size() << " parts, " << vertices.size() / 2
+         << " vertices, 2 draw calls" << endl;
+
+    vertices.clear();
+    colors.clear();
+}
+
+// draw all parts with one multi-draw-indirect call per primitive type
+void RenderDashboard(MyDashboard *dashboard)
+{
+    if (dashboardChanged)
+    {
+        BuildDashboard(dashboard);
+        dashboardChanged = false;
+    }
+
+    glUseProgram(dashboard->shader.program);
+    glBindVertexArray(dashboard->vertexArray);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, dashboard->indirectBuffer);
+
+    glMultiDrawArraysIndirect(GL_LINES, 0, dashboard->lineDraws, 0);
+    glMultiDrawArraysIndirect(GL_TRIANGLES,
+                              (const void *)(sizeof(DrawArraysIndirectCommand)*dashboard->lineDraws),
+                              dashboard->triangleDraws, 0);
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    glBindVertexArray(0);
+    glUseProgram(0);
+}
+
+// deallocate dashboard-related objects
+void DestroyDashboard(MyDashboard *dashboard)
+{
+    glBindVertexArray(0);
+    glDeleteVertexArrays(1, &dashboard->vertexArray);
+    glDeleteBuffers(1, &dashboard->vertexBuffer);
+    glDeleteBuffers(1, &dashboard->colourBuffer);
+    glDeleteBuffers(1, &dashboard->viewportBuffer);
+    glDeleteBuffers(1, &dashboard->indirectBuffer);
+    DestroyShaders(&dashboard->shader);
+}
+
+/**
+ * ================================================================================================
+ *
+ * The following code section targets the chaos game point cloud of part three
+ *
+ * ================================================================================================
+ */
+
+// toggled with the P key, draws part three as a point cloud that converges
+// over the frames instead of subdividing it to a level
+bool CHAOS_GAME = false;
+
+// points added every frame, each of them one run of the chaos game
+const GLsizei CHAOS_POINTS = 1 << 20;
+
+// jumps of every run, after 24 halvings a point is closer to the triangle
+// than floats resolve in the window
+const int CHAOS_ITERATIONS = 24;
+
+// frames accumulated before the image counts as converged, the window then
+// goes back to waiting for events
+const uint32_t CHAOS_CONVERGED_FRAMES = 64;
+
+struct MyChaosGame
+{
+    // the point shader adds every run into the accumulation texture, the
+    // resolve shader tone maps it into the window
+    MyShader point;
+    MyShader resolve;
+    GLuint  vertexArray;
+    GLuint  framebuffer;
+    GLuint  accumulation;
+
+    // size and view the accumulated frames were drawn with, a change of
+    // either starts again from nothing
+    int     width;
+    int     height;
+    double  centerX;
+    double  centerY;
+    double  zoom;
+    uint32_t frames;
+
+    MyChaosGame() : vertexArray(0), framebuffer(0), accumulation(0), width(0), height(0),
+        centerX(0), centerY(0), zoom(0), frames(0)
+    {}
+};
+
+// create the two programs, the empty vertex array and the framebuffer,
+// returning true if successful, the texture is sized when first drawn
+bool InitializeChaosGame(MyChaosGame *chaos)
+{
+    if (!InitializeProgram(&chaos->point, "vertex_chaos.glsl", "fragment_chaos.glsl")
+        || !InitializeProgram(&chaos->resolve, "vertex_chaos_resolve.glsl", "fragment_chaos_resolve.glsl"))
+        return false;
+
+    glGenVertexArrays(1, &chaos->vertexArray);
+    glGenFramebuffers(1, &chaos->framebuffer);
+    glGenTextures(1, &chaos->accumulation);
+
+    glBindTexture(GL_TEXTURE_2D, chaos->accumulation);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    return !CheckGLErrors();
+}
+
+// true while the point cloud is shown and still gaining detail
+bool ChaosGameConverging(MyChaosGame *chaos)
+{
+    return CHAOS_GAME && PART_THREE && !DASHBOARD && chaos->frames < CHAOS_CONVERGED_FRAMES;
+}
+
+/**
+ * @brief RenderChaosGame
+ * Adds another CHAOS_POINTS runs of the chaos game into the accumulation
+ * texture with additive blending, then shows their average over all frames
+ * so far. Memory is one float texture the size of the window whatever the
+ * level or the number of frames.
+ */
+void RenderChaosGame(MyChaosGame *chaos)
+{
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    int width = max(viewport[2], 1), height = max(viewport[3], 1);
+
+    if (chaos->width != width || chaos->height != height)
+    {
+        glBindTexture(GL_TEXTURE_2D, chaos->accumulation);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, width, height, 0, GL_RGBA, GL_FLOAT, NULL);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, chaos->framebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, chaos->accumulation, 0);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        chaos->width = width;
+        chaos->height = height;
+        chaos->frames = 0;
+        noteMemoryUse(0, (uint64_t)width * height * 4 * sizeof(float));
+    }
+    if (chaos->centerX != VIEW_CENTER_X || chaos->centerY != VIEW_CENTER_Y || chaos->zoom != VIEW_ZOOM)
+    {
+        chaos->centerX = VIEW_CENTER_X;
+        chaos->centerY = VIEW_CENTER_Y;
+        chaos->zoom = VIEW_ZOOM;
+        chaos->frames = 0;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, chaos->framebuffer);
+    if (chaos->frames == 0)
+    {
+        const GLfloat zero[] = { 0.f, 0.f, 0.f, 0.f };
+        glClearBufferfv(GL_COLOR, 0, zero);
+    }
+
+    glUseProgram(chaos->point.program);
+    glUniform1ui(glGetUniformLocation(chaos->point.program, "FirstPoint"), chaos->frames * CHAOS_POINTS);
+    glUniform1i(glGetUniformLocation(chaos->point.program, "Iterations"), CHAOS_ITERATIONS);
+    glUniform2f(glGetUniformLocation(chaos->point.program, "ViewCenter"), VIEW_CENTER_X, VIEW_CENTER_Y);
+    glUniform1f(glGetUniformLocation(chaos->point.program, "ViewZoom"), VIEW_ZOOM);
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE);
+    glBindVertexArray(chaos->vertexArray);
+    glDrawArrays(GL_POINTS, 0, CHAOS_POINTS);
+    glDisable(GL_BLEND);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    chaos->frames++;
+
+    glUseProgram(chaos->resolve.program);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, chaos->accumulation);
+    glUniform1i(glGetUniformLocation(chaos->resolve.program, "Accumulation"), 0);
+    glUniform1f(glGetUniformLocation(chaos->resolve.program, "Frames"), chaos->frames);
+    glUniform1f(glGetUniformLocation(chaos->resolve.program, "Exposure"), (float)CHAOS_POINTS / (width * height));
+    glUniform1i(glGetUniformLocation(chaos->resolve.program, "ColourScheme"), COLOUR_SCHEME);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindVertexArray(0);
+    glUseProgram(0);
+}
+
+// deallocate chaos game objects
+void DestroyChaosGame(MyChaosGame *chaos)
+{
+    glBindVertexArray(0);
+    glDeleteVertexArrays(1, &chaos->vertexArray);
+    glDeleteFramebuffers(1, &chaos->framebuffer);
+    glDeleteTextures(1, &chaos->accumulation);
+    DestroyShaders(&chaos->point);
+    DestroyShaders(&chaos->resolve);
+}
+
+/**
+ * ================================================================================================
+ *
+ * The following code section targets the on-disk mesh cache
+ *
+ * ================================================================================================
+ */
+
+// generated meshes are stored here, one file per part and level
+const string MESH_CACHE_DIRECTORY = "meshcache";
+
+// turned off with --no-mesh-cache, so that every run generates its meshes
+bool MESH_CACHE = true;
+
+// smaller meshes are quicker to generate than to read back, so skip them
+const uint64_t MESH_CACHE_MIN_VERTICES = 1 << 16;
+
+// check the payload checksum on every load, this reads every page of the
+// file up front so it is off by default
+const bool MESH_CACHE_VERIFY_PAYLOAD = false;
+
+// bump whenever a generator changes its output so old files are ignored
+const uint32_t MESH_FILE_VERSION = 3;
+
+// fixed-size header at the start of every mesh file, the attribute blocks
+// that follow each start on a page boundary so they can be handed to OpenGL
+// straight from the mapping
+struct MeshFileHeader
+{
+    char        magic[4];
+    uint32_t    version;
+    uint32_t    part;
+    uint32_t    level;
+    uint64_t    vertexCount;
+    uint32_t    primitive;
+    uint32_t    positionComponents;
+    uint32_t    colourComponents;
+    uint32_t    pageSize;
+    uint64_t    positionOffset;
+    uint64_t    positionBytes;
+    uint64_t    colourOffset;
+    uint64_t    colourBytes;
+    uint64_t    payloadChecksum;
+
+    // covers every field above
+    uint64_t    headerChecksum;
+};
+
+struct MappedMesh
+{
+    // the whole file as mapped into memory, null if nothing is mapped
+    void        *base;
+    size_t      size;
+
+    // attribute blocks inside the mapping
+    const float *positions;
+    const float *colours;
+    uint64_t    vertexCount;
+
+    MappedMesh() : base(NULL), size(0), positions(NULL), colours(NULL), vertexCount(0)
+    {}
+};
+
+// mesh of the current part when it came from the cache, consumed by the
+// next geometry upload
+MappedMesh mappedMesh;
+
+// set when the current part's geometry changes and needs to be uploaded
+bool geometryChanged = false;
+
+// set with geometryChanged when the geometry is only the left third of part
+// three, to be drawn once for every third
+bool geometryInThirds = false;
+
+string MeshCachePath(int part, int level)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "/part%d-level%d.mesh", part, level);
+    return MESH_CACHE_DIRECTORY + name;
+}
+
+uint64_t PageAlign(uint64_t offset, uint64_t pageSize)
+{
+    return (offset + pageSize - 1) / pageSize * pageSize;
+}
+
+void ReleaseMeshCache()
+{
+    if (mappedMesh.base)
+        munmap(mappedMesh.base, mappedMesh.size);
+    mappedMesh = MappedMesh();
+}
+
+// maps the cached mesh for this part and level, returning false if there is
+// no valid file, nothing is parsed or copied
+bool LoadMeshCache(int part, int level)
+{
+    ReleaseMeshCache();
+
+    int file = open(MeshCachePath(part, level).c_str(), O_RDONLY);
+    if (file < 0) return false;
+
+    struct stat info;
+    if (fstat(file, &info) != 0 || (size_t)info.st_size < sizeof(MeshFileHeader))
+    {
+        close(file);
+        return false;
+    }
+
+    int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+    // read the file in one sequential sweep rather than fault by fault
+    flags |= MAP_POPULATE;
+#endif
+    void *base = mmap(NULL, info.st_size, PROT_READ, flags, file, 0);
+    close(file);
+    if (base == MAP_FAILED) return false;
+
+    // the counts and offsets are checked against each other and the file size
+    // so that nothing past the mapping is ever handed to OpenGL
+    const MeshFileHeader *header = (const MeshFileHeader *)base;
+    uint64_t fileSize = info.st_size;
+    bool valid = memcmp(header->magic, "SFMC", 4) == 0
+                 && header->version == MESH_FILE_VERSION
+                 && header->headerChecksum == HashBytes(header, offsetof(MeshFileHeader, headerChecksum))
+                 && header->part == (uint32_t)part && header->level == (uint32_t)level
+                 && header->primitive == GL_TRIANGLES
+                 && header->positionComponents == 2
+                 && header->colourComponents == 3
+                 && header->pageSize == (uint32_t)sysconf(_SC_PAGESIZE)
+                 && header->vertexCount <= fileSize / (2 * sizeof(float))
+                 && header->positionBytes == header->vertexCount * 2 * sizeof(float)
+                 && header->colourBytes == header->vertexCount * header->colourComponents * sizeof(float)
+                 && header->positionOffset >= sizeof(MeshFileHeader)
+                 && header->positionOffset <= fileSize
+                 && header->colourOffset <= fileSize
+                 && header->positionOffset + header->positionBytes <= header->colourOffset
+                 && header->colourOffset + header->colourBytes == fileSize;
+
+    if (valid && MESH_CACHE_VERIFY_PAYLOAD)
+    {
+        uint64_t hash = HashBytes((const char *)base + header->positionOffset, header->positionBytes);
+        hash = HashBytes((const char *)base + header->colourOffset, header->colourBytes, hash);
+        valid = hash == header->payloadChecksum;
+    }
+
+    if (!valid)
+    {
+        cout << "Ignoring stale mesh cache " << MeshCachePath(part, level) << endl;
+        munmap(base, info.st_size);
+        return false;
+    }
+
+    mappedMesh.base = base;
+    mappedMesh.size = info.st_size;
+    mappedMesh.positions = (const float *)((const char *)base + header->positionOffset);
+    mappedMesh.colours = (const float *)((const char *)base + header->colourOffset);
+    mappedMesh.vertexCount = header->vertexCount;
+    return true;
+}
+
+// writes all of data to the file, false on failure
+bool WriteFully(int file, const void *data, size_t size)
+{
+    const char *bytes = (const char *)data;
+    while (size > 0)
+    {
+        ssize_t written = write(file, bytes, size);
+        if (written <= 0) return false;
+        bytes += written;
+        size -= written;
+    }
+    return true;
+}
+
+// stores the freshly generated vertices and colors of this part and level
+void SaveMeshCache(int part, int level, GLenum primitive)
+{
+    uint64_t vertexCount = vertices.size() / 2;
+    if (vertexCount < MESH_CACHE_MIN_VERTICES) return;
+
+    uint64_t pageSize = sysconf(_SC_PAGESIZE);
+
+    MeshFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "SFMC", 4);
+    header.version = MESH_FILE_VERSION;
+    header.part = part;
+    header.level = level;
+    header.vertexCount = vertexCount;
+    header.primitive = primitive;
+    header.positionComponents = 2;
+    header.colourComponents = colors.empty() ? 0 : 3;
+    header.pageSize = pageSize;
+    header.positionOffset = PageAlign(sizeof(header), pageSize);
+    header.positionBytes = vertices.size() * sizeof(float);
+    header.colourOffset = PageAlign(header.positionOffset + header.positionBytes, pageSize);
+    header.colourBytes = colors.size() * sizeof(float);
+    header.payloadChecksum = HashBytes(vertices.data(), header.positionBytes);
+    header.payloadChecksum = HashBytes(colors.data(), header.colourBytes, header.payloadChecksum);
+    header.headerChecksum = HashBytes(&header, offsetof(MeshFileHeader, headerChecksum));
+
+    // write to a temporary name first so a crash never leaves a torn file
+    mkdir(MESH_CACHE_DIRECTORY.c_str(), 0755);
+    string path = MeshCachePath(part, level);
+    string temporary = path + ".tmp";
+    int file = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (file < 0)
+    {
+        cout << "WARNING: Could not write mesh cache " << path << endl;
+        return;
+    }
+
+    vector<char> padding(pageSize, 0);
+    bool ok = WriteFully(file, &header, sizeof(header))
+              && WriteFully(file, &padding[0], header.positionOffset - sizeof(header))
+              && WriteFully(file, &vertices[0], header.positionBytes)
+              && WriteFully(file, &padding[0], header.colourOffset - header.positionOffset - header.positionBytes)
+              && WriteFully(file, colors.data(), header.colourBytes);
+    close(file);
+
+    if (ok) rename(temporary.c_str(), path.c_str());
+    else unlink(temporary.c_str());
+}
+
+// a shallow level uploaded straight from one of the compile-time tables
+struct StaticMesh
+{
+    const float *positions;
+    const float *colours;
+    uint64_t    vertexCount;
+
+    StaticMesh() : positions(NULL), colours(NULL), vertexCount(0)
+    {}
+};
+StaticMesh staticMesh;
+
+// points the static mesh at the level if a table holds it, returning true if so
+bool LoadStaticMesh(int part, int level)
+{
+    staticMesh = StaticMesh();
+
+    if (part == 3 && level <= SIERPINSKI_TABLE_LEVELS)
+    {
+        // the left third comes first in every level
+        int first = sierpinskiTableOffset(level);
+        staticMesh.positions = &sierpinskiTable.positions[first * 6];
+        staticMesh.colours = &sierpinskiTable.colours[first * 9];
+        staticMesh.vertexCount = 3 * sierpinskiLeafCount(geometryInThirds ? level - 1 : level);
+    }
+    return staticMesh.positions != NULL;
+}
+
+/**
+ * @brief generatePart
+ * @param part 1 or 3 for part one or three
+ * @param level
+ * Produces the geometry of the given part. The zoomed view of parts one and
+ * three is generated for the window, whole levels of part three are mapped
+ * from the mesh cache when a valid file exists and generated (then cached)
+ * otherwise.
+ */
+void generatePart(int part, int level)
+{
+    static const char *SCOPES[] = { "part one", "part two", "part three" };
+    AllocationScope allocations(SCOPES[min(max(part, 1), 3) - 1]);
+
+    // what the zoomed camera sees depends on the view, so it is neither baked
+    // in nor worth caching
+    geometryInThirds = false;
+    if (ViewIsZoomed() && (part == 1 || part == 3) && level >= 1)
+    {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        GENERATE_COLOURS = (part == 3);
+        if (part == 1)
+            renderSquaresAndDiamondsInView(level);
+        else
+            drawSierpinskiTriangleInView(level);
+        GENERATE_COLOURS = true;
+
+        chrono::duration<double, milli> generation = chrono::steady_clock::now() - start;
+        renderStats.generationMilliseconds += generation.count();
+        ReleaseMeshCache();
+        staticMesh = StaticMesh();
+        geometryChanged = true;
+        return;
+    }
+
+    // the whole of part one is instances of one square, see MySquares, so
+    // only part three is generated or cached from here on
+    if (part != 3)
+    {
+        ReleaseMeshCache();
+        staticMesh = StaticMesh();
+        return;
+    }
+
+    // the thirds of part three are one mesh moved and tinted by the shader
+    geometryInThirds = (level >= 2);
+
+    // shallow levels need neither generating nor caching
+    if (LoadStaticMesh(part, level))
+    {
+        ReleaseMeshCache();
+        geometryChanged = true;
+        return;
+    }
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    geometryChanged = true;
+
+    if (MESH_CACHE && LoadMeshCache(part, level))
+    {
+        chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+        renderStats.generationMilliseconds += elapsed.count();
+        cout << "Part " << part << " level " << level << " mapped from mesh cache ("
+             << mappedMesh.size / (1024 * 1024) << " MB) in " << elapsed.count() << " ms" << endl;
+        return;
+    }
+
+    if (geometryInThirds)
+        drawSierpinskiThird(level);
+    else
+        drawSierpinskiTriangle(level);
+
+    chrono::duration<double, milli> generation = chrono::steady_clock::now() - start;
+    renderStats.generationMilliseconds += generation.count();
+
+    if (MESH_CACHE)
+        SaveMeshCache(part, level, GL_TRIANGLES);
+
+    if (MESH_CACHE && vertices.size() / 2 >= MESH_CACHE_MIN_VERTICES)
+    {
+        chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+        cout << "Part " << part << " level " << level << " generated and cached in "
+             << elapsed.count() << " ms" << endl;
+    }
+}
+
+/**
+ * ================================================================================================
+ *
+ * The following code section targets streaming export to SVG, OBJ and raw binary files
+ *
+ * ================================================================================================
+ */
+
+// size of the write buffer, also the size of every write except the last
+const size_t EXPORT_BUFFER_SIZE = 4 << 20;
+
+// buffered writer issuing large page-aligned writes to a file or stdout,
+// memory use does not depend on how much is written
+struct StreamWriter
+{
+    int         file;
+    char        *buffer;
+    size_t      used;
+    uint64_t    written;
+    bool        failed;
+
+    StreamWriter() : file(-1), buffer(NULL), used(0), written(0), failed(false)
+    {}
+};
+
+// opens the writer on the given path, "-" means standard output
+bool OpenStreamWriter(StreamWriter *writer, const string &path)
+{
+    writer->file = (path == "-") ? STDOUT_FILENO
+                                 : open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (writer->file < 0) return false;
+
+    void *buffer = NULL;
+    if (posix_memalign(&buffer, 4096, EXPORT_BUFFER_SIZE) != 0)
+    {
+        if (writer->file != STDOUT_FILENO)
+            close(writer->file);
+        writer->file = -1;
+        return false;
+    }
+    writer->buffer = (char *)buffer;
+    return true;
+}
+
+void FlushStreamWriter(StreamWriter *writer)
+{
+    if (!writer->failed && writer->used > 0 && !WriteFully(writer->file, writer->buffer, writer->used))
+        writer->failed = true;
+    writer->written += writer->used;
+    writer->used = 0;
+}
+
+void WriteBytes(StreamWriter *writer, const void *data, size_t size)
+{
+    const char *bytes = (const char *)data;
+    while (size > 0)
+    {
+        size_t chunk = min(size, EXPORT_BUFFER_SIZE - writer->used);
+        memcpy(writer->buffer + writer->used, bytes, chunk);
+        writer->used += chunk;
+        bytes += chunk;
+        size -= chunk;
+        if (writer->used == EXPORT_BUFFER_SIZE)
+            FlushStreamWriter(writer);
+    }
+}
+
+// formats text straight into the write buffer
+void WriteText(StreamWriter *writer, const char *format, ...)
+{
+    // no single record comes anywhere close to this
+    const size_t MAX_RECORD = 512;
+    if (EXPORT_BUFFER_SIZE - writer->used < MAX_RECORD)
+        FlushStreamWriter(writer);
+
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(writer->buffer + writer->used, MAX_RECORD, format, args);
+    va_end(args);
+    if (length > 0)
+        writer->used += min((size_t)length, MAX_RECORD - 1);
+}
+
+// flushes and closes the writer, returning false if any write failed
+bool CloseStreamWriter(StreamWriter *writer)
+{
+    FlushStreamWriter(writer);
+    if (writer->file >= 0 && writer->file != STDOUT_FILENO)
+        close(writer->file);
+    free(writer->buffer);
+    writer->buffer = NULL;
+    writer->file = -1;
+    return !writer->failed;
+}
+
+// collects the corners of the current primitive until its colour arrives,
+// which is when the exporters below write it out
+struct ExportSink : public PrimitiveSink
+{
+    StreamWriter    *writer;
+    float           corners[6];
+    int             cornerCount;
+    uint64_t        primitives;
+
+    ExportSink(StreamWriter *output) : writer(output), cornerCount(0), primitives(0)
+    {}
+
+    void line(float x1, float y1, float x2, float y2)
+    {
+        corners[0] = x1; corners[1] = y1;
+        corners[2] = x2; corners[3] = y2;
+        cornerCount = 2;
+    }
+
+    void triangle(const Triangle &triangle)
+    {
+        corners[0] = triangle.left.x;  corners[1] = triangle.left.y;
+        corners[2] = triangle.top.x;   corners[3] = triangle.top.y;
+        corners[4] = triangle.right.x; corners[5] = triangle.right.y;
+        cornerCount = 3;
+    }
+
+    void colour(float r, float g, float b)
+    {
+        write(r, g, b);
+        primitives++;
+    }
+
+    virtual void begin() {}
+    virtual void write(float r, float g, float b) = 0;
+    virtual void end() {}
+};
+
+int ColourByte(float value)
+{
+    return (int)(min(max(value, 0.f), 1.f) * 255.f + 0.5f);
+}
+
+// one path element per primitive, y is flipped to match OpenGL
+struct SvgExportSink : public ExportSink
+{
+    SvgExportSink(StreamWriter *output) : ExportSink(output) {}
+
+    void begin()
+    {
+        WriteText(writer, "<svg xmlns=\"http://www.w3.org/2000/svg\" viewBox=\"-1 -1 2 2\">\n"
+                          "<rect x=\"-1\" y=\"-1\" width=\"2\" height=\"2\" fill=\"white\"/>\n"
+                          "<g transform=\"scale(1,-1)\" stroke-width=\"0.004\">\n");
+    }
+
+    void write(float r, float g, float b)
+    {
+        char colour[8];
+        snprintf(colour, sizeof(colour), "#%02x%02x%02x", ColourByte(r), ColourByte(g), ColourByte(b));
+        if (cornerCount == 2)
+            WriteText(writer, "<path d=\"M%g %gL%g %g\" stroke=\"%s\"/>\n",
+                      corners[0], corners[1], corners[2], corners[3], colour);
+        else
+            WriteText(writer, "<path d=\"M%g %gL%g %gL%g %gZ\" fill=\"%s\"/>\n",
+                      corners[0], corners[1], corners[2], corners[3], corners[4], corners[5], colour);
+    }
+
+    void end()
+    {
+        WriteText(writer, "</g>\n</svg>\n");
+    }
+};
+
+// vertices carry their colour (the common "v x y z r g b" extension) and
+// are referenced by a running index, so nothing has to be remembered
+struct ObjExportSink : public ExportSink
+{
+    uint64_t    nextIndex;
+
+    ObjExportSink(StreamWriter *output) : ExportSink(output), nextIndex(1) {}
+
+    void begin()
+    {
+        WriteText(writer, "# CPSC 453 fractal export\n");
+    }
+
+    void write(float r, float g, float b)
+    {
+        for (int i = 0; i < cornerCount; i++)
+            WriteText(writer, "v %g %g 0 %g %g %g\n", corners[2*i], corners[2*i + 1], r, g, b);
+
+        if (cornerCount == 2)
+            WriteText(writer, "l %llu %llu\n", (unsigned long long)nextIndex,
+                      (unsigned long long)(nextIndex + 1));
+        else
+            WriteText(writer, "f %llu %llu %llu\n", (unsigned long long)nextIndex,
+                      (unsigned long long)(nextIndex + 1), (unsigned long long)(nextIndex + 2));
+        nextIndex += cornerCount;
+    }
+};
+
+// a small header followed by one fixed-size record per primitive, the
+// corners (x, y pairs) and then the colour (r, g, b), all 32-bit floats
+struct RawExportHeader
+{
+    char        magic[4];
+    uint32_t    version;
+    uint32_t    cornersPerPrimitive;
+    uint32_t    reserved;
+
+    // only filled in when the output is seekable, zero when streaming
+    uint64_t    primitiveCount;
+};
+
+struct RawExportSink : public ExportSink
+{
+    uint32_t    cornersPerPrimitive;
+
+    RawExportSink(StreamWriter *output, uint32_t corners)
+        : ExportSink(output), cornersPerPrimitive(corners) {}
+
+    RawExportHeader header()
+    {
+        RawExportHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, "SFRW", 4);
+        header.version = 1;
+        header.cornersPerPrimitive = cornersPerPrimitive;
+        header.primitiveCount = primitives;
+        return header;
+    }
+
+    void begin()
+    {
+        RawExportHeader start = header();
+        WriteBytes(writer, &start, sizeof(start));
+    }
+
+    void write(float r, float g, float b)
+    {
+        float record[9];
+        memcpy(record, corners, sizeof(float) * 2 * cornerCount);
+        record[2*cornerCount] = r;
+        record[2*cornerCount + 1] = g;
+        record[2*cornerCount + 2] = b;
+        WriteBytes(writer, record, sizeof(float) * (2*cornerCount + 3));
+    }
+
+    void end()
+    {
+        // patch the primitive count in place, this fails harmlessly on pipes
+        FlushStreamWriter(writer);
+        RawExportHeader finished = header();
+        if (pwrite(writer->file, &finished, sizeof(finished), 0) != (ssize_t)sizeof(finished))
+            cerr << "Raw export is not seekable, primitive count left at zero" << endl;
+    }
+};
+
+/**
+ * @brief exportPart
+ * @param format svg, obj or raw
+ * @param path output file, or - for standard output
+ * Streams the primitives of a part straight from its generator to the file,
+ * so memory use stays constant regardless of the level.
+ */
+bool exportPart(const string &format, const string &path, int part, int level)
+{
+    if (part < 1 || part > 3 || level < 1)
+    {
+        cerr << "ERROR: Cannot export part " << part << " at level " << level << endl;
+        return false;
+    }
+
+    StreamWriter writer;
+    if (!OpenStreamWriter(&writer, path))
+    {
+        cerr << "ERROR: Could not open " << path << " for export" << endl;
+        return false;
+    }
+
+    ExportSink *sink = NULL;
+    if (format == "svg")
+        sink = new SvgExportSink(&writer);
+    else if (format == "obj")
+        sink = new ObjExportSink(&writer);
+    else if (format == "raw")
+        sink = new RawExportSink(&writer, part == 3 ? 3 : 2);
+    else
+    {
+        cerr << "ERROR: Unknown export format " << format << " (use svg, obj or raw)" << endl;
+        CloseStreamWriter(&writer);
+        return false;
+    }
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    AllocationScope allocations("export");
+
+    sink->begin();
+    primitiveSink = sink;
+    if (part == 1)
+        renderSquaresAndDiamonds(level);
+    else if (part == 2)
+        doPartTwo(level);
+    else
+        drawSierpinskiTriangle(level);
+    primitiveSink = NULL;
+    sink->end();
+
+    uint64_t primitives = sink->primitives;
+    delete sink;
+    bool ok = CloseStreamWriter(&writer);
+
+    // progress goes to stderr so that exporting to stdout stays clean
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    cerr << "Exported " << primitives << " primitives of part " << part << " level " << level
+         << " as " << format << " (" << writer.written / (1024.0 * 1024.0) << " MB) in "
+         << elapsed.count() << " s" << (ok ? "" : " [WRITE FAILED]") << endl;
+    return ok;
+}
+
+/**
+ * ================================================================================================
+ *
+ * The following code section targets the density renderer of iterated function systems
+ *
+ * ================================================================================================
+ */
+
+// one affine map of an iterated function system, x' = a x + b y + e and
+// y' = c x + d y + f, chosen with the given probability
+struct AffineMap
+{
+    double  a, b, c, d, e, f;
+    double  probability;
+};
+
+// jumps made from the origin before a stream starts counting, by then every
+// point is on the attractor to within a pixel
+const int IFS_WARMUP_JUMPS = 32;
+
+// jumps used to find the bounds of the attractor before rendering it
+const int IFS_BOUNDS_SAMPLES = 1 << 16;
+
+// samples a stream adds to its 32-bit histogram before the histograms are
+// merged into 64-bit totals, so that no pixel count can wrap
+const uint64_t IFS_ROUND_SAMPLES = 0xffffffffull;
+
+// xorshift64* generator, every thread has a stream of its own
+struct IfsRandom
+{
+    uint64_t state;
+
+    // splitmix64 of the stream index, so that neighbouring streams start far
+    // apart and never at zero
+    IfsRandom(uint64_t stream)
+    {
+        uint64_t z = stream * 0x9e3779b97f4a7c15ull + 0x9e3779b97f4a7c15ull;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        state = (z ^ (z >> 31)) | 1;
+    }
+
+    uint32_t next()
+    {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return (uint32_t)((state * 0x2545f4914f6cdd1dull) >> 32);
+    }
+};
+
+/**
+ * @brief loadIteratedFunctionSystem
+ * Reads one map per line as "a b c d e f p", the layout of the classic .ifs
+ * files. Blank lines and anything after a # are ignored, and the
+ * probabilities are scaled to sum to one.
+ * @return false after printing why if the file cannot be read or has no maps
+ */
+bool loadIteratedFunctionSystem(const string &path, vector<AffineMap> &maps)
+{
+    ifstream file(path.c_str());
+    if (!file)
+    {
+        cerr << "ERROR: Could not open " << path << endl;
+        return false;
+    }
+
+    maps.clear();
+    double total = 0;
+    string line;
+    for (int number = 1; getline(file, line); number++)
+    {
+        line = line.substr(0, line.find('#'));
+        if (line.find_first_not_of(" \t\r") == string::npos)
+            continue;
+
+        AffineMap map;
+        if (sscanf(line.c_str(), "%lf %lf %lf %lf %lf %lf %lf", &map.a, &map.b, &map.c, &map.d,
+                   &map.e, &map.f, &map.probability) != 7 || map.probability < 0)
+        {
+            cerr << "ERROR: " << path << ":" << number << ": expected a b c d e f p" << endl;
+            return false;
+        }
+        maps.push_back(map);
+        total += map.probability;
+    }
+
+    if (maps.empty() || total <= 0)
+    {
+        cerr << "ERROR: " << path << " has no maps" << endl;
+        return false;
+    }
+    for (size_t i = 0; i < maps.size(); i++)
+        maps[i].probability /= total;
+    return true;
+}
+
+/**
+ * @brief renderIteratedFunctionSystem
+ * Plays the chaos game with the maps of an .ifs file on every thread at once,
+ * each thread with its own random stream and its own histogram of hits, so
+ * that the threads share nothing until their histograms are summed. The
+ * logarithm of the hits is written as a binary PPM image, dark on white.
+ * @param samples points counted over all threads
+ * @param threads streams to run, spread over the hardware threads
+ * @return false after printing why if the file or the image fails
+ */
+bool renderIteratedFunctionSystem(const string &ifsPath, const string &imagePath, uint64_t samples,
+                                  int threads, int width, int height)
+{
+    vector<AffineMap> maps;
+    if (!loadIteratedFunctionSystem(ifsPath, maps))
+        return false;
+
+    // maps are picked by comparing 32 random bits with these thresholds
+    vector<uint32_t> thresholds(maps.size());
+    double cumulative = 0;
+    for (size_t i = 0; i < maps.size(); i++)
+    {
+        cumulative += maps[i].probability;
+        thresholds[i] = (uint32_t)min(cumulative * 4294967296.0, 4294967295.0);
+    }
+    thresholds.back() = 0xffffffffu;
+
+    // applies a random map to the point, returning its index
+    auto jump = [&](IfsRandom &random, double &x, double &y)
+    {
+        uint32_t pick = random.next();
+        size_t i = 0;
+        while (pick > thresholds[i])
+            i++;
+        const AffineMap &m = maps[i];
+        double nx = m.a * x + m.b * y + m.e;
+        y = m.c * x + m.d * y + m.f;
+        x = nx;
+    };
+
+    // the bounds of the attractor, widened a little and to the shape of the image
+    double minX = HUGE_VAL, minY = HUGE_VAL, maxX = -HUGE_VAL, maxY = -HUGE_VAL;
+    {
+        IfsRandom random(0);
+        double x = 0, y = 0;
+        for (int i = 0; i < IFS_WARMUP_JUMPS + IFS_BOUNDS_SAMPLES && isfinite(x) && isfinite(y); i++)
+        {
+            jump(random, x, y);
+            if (i < IFS_WARMUP_JUMPS)
+                continue;
+            minX = min(minX, x); maxX = max(maxX, x);
+            minY = min(minY, y); maxY = max(maxY, y);
+        }
+        // min() and max() skip a NaN, so the point itself is checked too
+        if (!isfinite(x) || !isfinite(y))
+            minX = HUGE_VAL;
+    }
+    if (!(maxX >= minX && maxY >= minY) || isinf(maxX - minX) || isinf(maxY - minY))
+    {
+        cerr << "ERROR: The maps of " << ifsPath << " do not contract to an attractor" << endl;
+        return false;
+    }
+    double scale = 0.95 * min(width / max(maxX - minX, 1e-12), height / max(maxY - minY, 1e-12));
+    double centerX = 0.5 * (minX + maxX), centerY = 0.5 * (minY + maxY);
+
+    // every thread holds a 32-bit histogram next to the 64-bit totals, so
+    // fewer threads run if they would not all fit the host memory budget
+    size_t pixels = (size_t)width * height;
+    uint64_t totalBytes = pixels * sizeof(uint64_t);
+    uint64_t spare = HOST_MEMORY_BUDGET > totalBytes ? HOST_MEMORY_BUDGET - totalBytes : 0;
+    threads = (int)min((uint64_t)max(threads, 1), max(spare / (pixels * sizeof(uint32_t)), (uint64_t)1));
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    AllocationScope allocations("ifs");
+    vector<vector<uint32_t> > histograms(threads, vector<uint32_t>(pixels, 0));
+    vector<uint64_t> hits(pixels, 0);
+
+    // every stream carries its generator and point over from round to round
+    vector<IfsRandom> randoms;
+    vector<double> xs(threads, 0.0), ys(threads, 0.0);
+    vector<uint64_t> remaining(threads);
+    for (int stream = 0; stream < threads; stream++)
+    {
+        randoms.push_back(IfsRandom(stream + 1));
+        for (int i = 0; i < IFS_WARMUP_JUMPS; i++)
+            jump(randoms[stream], xs[stream], ys[stream]);
+        remaining[stream] = samples * (stream + 1) / threads - samples * stream / threads;
+    }
+
+    chrono::duration<double> iteration(0);
+    while (*max_element(remaining.begin(), remaining.end()) > 0)
+    {
+        chrono::steady_clock::time_point roundStart = chrono::steady_clock::now();
+        parallelFor(threads, 1, [&](size_t first, size_t last)
+        {
+            for (size_t stream = first; stream < last; stream++)
+            {
+                IfsRandom &random = randoms[stream];
+                uint32_t *histogram = &histograms[stream][0];
+                uint64_t count = min(remaining[stream], IFS_ROUND_SAMPLES);
+                remaining[stream] -= count;
+
+                // compared as doubles, so a point far outside the image or
+                // not finite at all is never converted to an int
+                double x = xs[stream], y = ys[stream];
+                for (uint64_t i = 0; i < count; i++)
+                {
+                    jump(random, x, y);
+                    double column = floor((x - centerX) * scale + 0.5 * width);
+                    double row = floor((centerY - y) * scale + 0.5 * height);
+                    if (column >= 0 && column < width && row >= 0 && row < height)
+                        histogram[(size_t)row * width + (size_t)column]++;
+                }
+                xs[stream] = x;
+                ys[stream] = y;
+            }
+        });
+        iteration += chrono::steady_clock::now() - roundStart;
+
+        // add the round into the totals, split over the pixels this time
+        parallelFor(pixels, 1 << 16, [&](size_t first, size_t last)
+        {
+            for (int stream = 0; stream < threads; stream++)
+                for (size_t i = first; i < last; i++)
+                {
+                    hits[i] += histograms[stream][i];
+                    histograms[stream][i] = 0;
+                }
+        });
+    }
+    uint64_t maximum = *max_element(hits.begin(), hits.end());
+
+    StreamWriter writer;
+    if (!OpenStreamWriter(&writer, imagePath))
+    {
+        cerr << "ERROR: Could not open " << imagePath << " for the image" << endl;
+        return false;
+    }
+    WriteText(&writer, "P6\n%d %d\n255\n", width, height);
+    double range = log1p((double)maximum);
+    for (size_t i = 0; i < pixels; i++)
+    {
+        unsigned char shade = (unsigned char)ColourByte((float)(1.0 - log1p((double)hits[i]) / max(range, 1e-9)));
+        const unsigned char rgb[3] = { shade, shade, shade };
+        WriteBytes(&writer, rgb, 3);
+    }
+    bool ok = CloseStreamWriter(&writer);
+
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    cerr << "Rendered " << samples << " samples of " << ifsPath << " (" << maps.size() << " maps) on "
+         << threads << " thread(s) in " << iteration.count() << " s, " << samples / iteration.count() / 1e6
+         << " M samples/s, image written in " << elapsed.count() << " s" << (ok ? "" : " [WRITE FAILED]") << endl;
+    return ok;
+}
+
+/**
+ * ================================================================================================
+ *
+ * The following code section targets recording key events for deterministic replay
+ *
+ * ================================================================================================
+ */
+
+// a key log is this header followed by one KeyLogEvent per key event
+struct KeyLogHeader
+{
+    char        magic[4];       // "SFKL"
+    uint32_t    version;
+};
+
+const uint32_t KEY_LOG_VERSION = 1;
+
+struct KeyLogEvent
+{
+    uint32_t    delay;          // microseconds since the previous event
+    int16_t     key;
+    int16_t     scancode;
+    uint8_t     action;         // GLFW_PRESS, GLFW_RELEASE or GLFW_REPEAT
+    uint8_t     mods;
+    uint16_t    reserved;
+};
+
+static_assert(sizeof(KeyLogEvent) == 12, "Key log events should stay 12 bytes");
+
+struct MyKeyRecorder
+{
+    StreamWriter    writer;
+    bool            active;
+    uint64_t        events;
+
+    // time of the previous event, or of the start of the recording
+    chrono::steady_clock::time_point last;
+
+    MyKeyRecorder() : active(false), events(0)
+    {}
+};
+MyKeyRecorder keyRecorder;
+
+// starts logging key events to the given file, returning true if successful
+bool OpenKeyRecorder(MyKeyRecorder *recorder, const string &path)
+{
+    if (!OpenStreamWriter(&recorder->writer, path))
+    {
+        cerr << "ERROR: Could not open " << path << " to record key events" << endl;
+        return false;
+    }
+
+    KeyLogHeader header;
+    memcpy(header.magic, "SFKL", 4);
+    header.version = KEY_LOG_VERSION;
+    WriteBytes(&recorder->writer, &header, sizeof(header));
+
+    recorder->active = true;
+    recorder->events = 0;
+    recorder->last = chrono::steady_clock::now();
+    return true;
+}
+
+// appends one key event, flushed at once so a crash keeps every event before it
+void RecordKeyEvent(MyKeyRecorder *recorder, int key, int scancode, int action, int mods)
+{
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+    chrono::duration<double, micro> delay = now - recorder->last;
+    recorder->last = now;
+
+    KeyLogEvent event;
+    event.delay = (uint32_t)min(delay.count(), (double)UINT32_MAX);
+    event.key = (int16_t)key;
+    event.scancode = (int16_t)scancode;
+    event.action = (uint8_t)action;
+    event.mods = (uint8_t)mods;
+    event.reserved = 0;
+
+    WriteBytes(&recorder->writer, &event, sizeof(event));
+    FlushStreamWriter(&recorder->writer);
+    recorder->events++;
+}
+
+void CloseKeyRecorder(MyKeyRecorder *recorder)
+{
+    if (!recorder->active)
+        return;
 
-    vertices.push_back(triangle.LowerLine.startPoint.x);
-    vertices.push_back(triangle.LowerLine.startPoint.y);
+    bool ok = CloseStreamWriter(&recorder->writer);
+    recorder->active = false;
+    cout << "Recorded " << recorder->events << " key events" << (ok ? "" : " [WRITE FAILED]") << endl;
 }
 
-void addColorsToTriangles(float r, float g, float b)
+// reads every event of a key log, returning false if it is missing or not a key log
+bool LoadKeyLog(const string &path, vector<KeyLogEvent> &events)
 {
-        colors.push_back(r);
-        colors.push_back(g);
-        colors.push_back(b);
+    ifstream input(path.c_str(), ios::binary);
+    KeyLogHeader header;
+    if (!input.read((char *)&header, sizeof(header)) || memcmp(header.magic, "SFKL", 4) != 0
+        || header.version != KEY_LOG_VERSION)
+    {
+        cerr << "ERROR: " << path << " is not a key log" << endl;
+        return false;
+    }
 
-        colors.push_back(r);
-        colors.push_back(g);
-        colors.push_back(b);
+    KeyLogEvent event;
+    events.clear();
+    while (input.read((char *)&event, sizeof(event)))
+        events.push_back(event);
+    return true;
+}
 
-        colors.push_back(r);
-        colors.push_back(g);
-        colors.push_back(b);
+/**
+ * ================================================================================================
+ *
+ * The following code section targets KeyBoard events and their handlers
+ *
+ * ================================================================================================
+ */
+// true for the parts the camera can zoom into and pan around
+bool viewZoomable()
+{
+    return (PART_ONE || PART_THREE) && !DASHBOARD;
 }
 
-float nextRColor = 0.4f;
-float nextGColor = 0.4f;
-float nextBColor = 0.4f;
+void handleLeftRightKeys(){
+    // a part is first seen whole
+    setView(0.0, 0.0, 1.0);
 
-void displaySierpinskiTriangle(int level, Triangle tr, int whichSide)
-{
-    if(level == 1 && whichSide == BASE_TRIANGLE)
+    // the squares of part one and the spiral of part two are drawn without
+    // generating anything
+    if(PART_THREE)
+    {
+        if(!CHAOS_GAME && !UseComputeSierpinski(1) && !UseOutOfCoreSierpinski(1))
+            generatePart(3, 1);
+        nextRColor = 0.4f;
+        nextGColor = 0.4f;
+        nextBColor = 0.4f;
+    }
+    // the carpet and the solids are generated when they are next drawn
+
+    // every other part starts again from its first level
+    for(int part = 1; part <= PART_COUNT; part++)
+        if(part != currentPart())
+            *partLevels(part) = 1;
+}
+
+void handleUpDowntKeys(){
+    if(PART_ONE)
+    {
+        // only the zoomed view generates anything, the whole part is instanced
+        PART_ONE_LEVELS = max(PART_ONE_LEVELS, 1);
+        if(ViewIsZoomed())
+            generatePart(1, PART_ONE_LEVELS);
+    }
+    else if(PART_TWO)
+    {
+        // the spiral only needs its level as a uniform when it is next drawn,
+        // and a vertex count that a draw call takes
+        int maxLevel = (int)((MAX_DRAW_COUNT - 1) * 0.01 / (2 * M_PI));
+        PART_TWO_LEVELS = min(max(PART_TWO_LEVELS, 1), maxLevel);
+    }
+    else if(PART_THREE)
     {
-        displayTriangle(tr);
-        addColorsToTriangles(0.41f, 0.41f, 0.41f);
+        if(PART_THREE_LEVELS > SIERPINSKI_MAX_LEVEL)
+            cout << "Part three level " << PART_THREE_LEVELS << " is deeper than level "
+                 << SIERPINSKI_MAX_LEVEL << ", the last one with 64-bit triangle counts" << endl;
+        PART_THREE_LEVELS = min(max(PART_THREE_LEVELS, 1), SIERPINSKI_MAX_LEVEL);
+
+        // the point cloud is the same at every level
+        // said once per level, dragging the whole part comes through here too
+        static int reportedLevel = 0;
+        int level = sierpinskiDrawnLevel(PART_THREE_LEVELS);
+        if(!CHAOS_GAME && level != PART_THREE_LEVELS && reportedLevel != PART_THREE_LEVELS)
+            cout << "Part three level " << PART_THREE_LEVELS << " is finer than a pixel, drawing level "
+                 << level << " until zoomed in" << endl;
+        reportedLevel = (level != PART_THREE_LEVELS) ? PART_THREE_LEVELS : 0;
+        if(!CHAOS_GAME && !UseComputeSierpinski(level) && !UseOutOfCoreSierpinski(level))
+            generatePart(3, level);
+        else if(!CHAOS_GAME && !OUT_OF_CORE && UseOutOfCoreSierpinski(level))
+            cout << "Part three level " << level << " needs "
+                 << sceneSize(3, level - 1).bytes / (1024 * 1024)
+                 << " MB, over the memory budget, drawing it in chunks" << endl;
+
+        nextRColor = 0.4f;
+        nextGColor = 0.4f;
+        nextBColor = 0.4f;
     }
-    else if(level == 1)
+    else if(PART_FOUR || PART_FIVE || PART_SIX)
     {
-        displayTriangle(tr);
+        // the carpet and the solids are regenerated when they are next drawn,
+        // at the deepest level that fits the memory budget
+        static const int MAX_LEVELS[] = { CARPET_MAX_LEVEL, TETRAHEDRON_MAX_LEVEL, MENGER_MAX_LEVEL };
+        static const char *SCENES[] = { "Carpet", "Tetrahedron", "Menger sponge" };
+        int part = currentPart();
+        int *level = partLevels(part);
+        *level = min(max(*level, 1), MAX_LEVELS[part - 4]);
+
+        int lowered = levelWithinBudget(part, *level);
+        if (lowered != *level)
+            reportLevelOverBudget(SCENES[part - 4], part, *level, lowered);
+        *level = lowered;
+    }
+}
+
+void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+    if (keyRecorder.active)
+        RecordKeyEvent(&keyRecorder, key, scancode, action, mods);
+
+    if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, GL_TRUE);
 
-        if(whichSide == LEFT)
+    if(key == GLFW_KEY_S && action == GLFW_PRESS)
+    {
+        glClearColor(1.0, 1.0, 1.0, 1.0);
+        glClear(GL_COLOR_BUFFER_BIT);
+        PART_ONE = true;
+        handleLeftRightKeys();
+    }
+    if(key == GLFW_KEY_D && action == GLFW_PRESS)
+    {
+        if(multiDrawIndirectSupported)
         {
-            nextRColor += 0.009f;
-            addColorsToTriangles(nextRColor ,0.f,0.f);
+            glClearColor(1.0, 1.0, 1.0, 1.0);
+            glClear(GL_COLOR_BUFFER_BIT);
+
+            DASHBOARD = !DASHBOARD;
+            dashboardChanged = true;
+
+            // regenerate the single part we are returning to
+            if(!DASHBOARD)
+                handleUpDowntKeys();
         }
-        if(whichSide == RIGHT)
-        {
-            nextGColor += 0.009f;
-            addColorsToTriangles(0.f, nextGColor, 0.f);
-        }if(whichSide == UP)
-        {
-            nextBColor += 0.009f;
-            addColorsToTriangles(0.f,0.f, nextBColor);
+        else {
+            cout << "Multi-draw-indirect is not supported by this OpenGL context" << endl;
         }
         return;
     }
-    else
+    if(DASHBOARD && (key == GLFW_KEY_UP || key == GLFW_KEY_DOWN) && action == GLFW_PRESS)
+    {
+        // in the dashboard the up/down keys change the level of every part
+        glClearColor(1.0, 1.0, 1.0, 1.0);
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        int change = (key == GLFW_KEY_UP) ? 1 : -1;
+        PART_ONE_LEVELS = max(PART_ONE_LEVELS + change, 1);
+        PART_TWO_LEVELS = max(PART_TWO_LEVELS + change, 1);
+        PART_THREE_LEVELS = max(PART_THREE_LEVELS + change, 1);
+        dashboardChanged = true;
+        return;
+    }
+    if(key == GLFW_KEY_O && action == GLFW_PRESS)
     {
-        if(whichSide == BASE_TRIANGLE){
-            displaySierpinskiTriangle(level -1, getLeftTriangle(tr), LEFT);
-            displaySierpinskiTriangle(level - 1, getUpperTriangle(tr), UP);
-            displaySierpinskiTriangle(level - 1, getRightTriangle(tr), RIGHT);
-        }else{
-            displaySierpinskiTriangle(level -1, getLeftTriangle(tr), whichSide);
-            displaySierpinskiTriangle(level - 1, getUpperTriangle(tr), whichSide);
-            displaySierpinskiTriangle(level - 1, getRightTriangle(tr), whichSide);
+        glClearColor(1.0, 1.0, 1.0, 1.0);
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        OUT_OF_CORE = !OUT_OF_CORE;
+        cout << "Out-of-core rendering of part three " << (OUT_OF_CORE ? "on" : "off") << endl;
+        handleUpDowntKeys();
+    }
+    if(key == GLFW_KEY_P && action == GLFW_PRESS)
+    {
+        glClearColor(1.0, 1.0, 1.0, 1.0);
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        CHAOS_GAME = !CHAOS_GAME;
+        cout << "Part three drawn as " << (CHAOS_GAME ? "a chaos game point cloud" : "triangles") << endl;
+        handleUpDowntKeys();
+    }
+    if(key == GLFW_KEY_G && action == GLFW_PRESS)
+    {
+        if(computeShaderSupported)
+        {
+            glClearColor(1.0, 1.0, 1.0, 1.0);
+            glClear(GL_COLOR_BUFFER_BIT);
+
+            COMPUTE_SIERPINSKI = !COMPUTE_SIERPINSKI;
+            cout << "Part three generated on the " << (COMPUTE_SIERPINSKI ? "GPU" : "CPU") << endl;
+            handleUpDowntKeys();
         }
+        else {
+            cout << "Compute shaders are not supported by this OpenGL context" << endl;
+        }
+    }
+    if((key == GLFW_KEY_Z || key == GLFW_KEY_X || key == GLFW_KEY_R) && action == GLFW_PRESS
+       && viewZoomable())
+    {
+        glClearColor(1.0, 1.0, 1.0, 1.0);
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        // zoom in or out around the middle of the window, or see the whole part again
+        if(key == GLFW_KEY_R)
+            setView(0.0, 0.0, 1.0);
+        else
+            zoomView(key == GLFW_KEY_Z ? 2.0 : 0.5, 0.0, 0.0);
+        cout << "Zoom " << VIEW_ZOOM << " around (" << VIEW_CENTER_X << ", " << VIEW_CENTER_Y << ")" << endl;
+        handleUpDowntKeys();
+    }
+    if(key == GLFW_KEY_C && action == GLFW_PRESS)
+    {
+        // only a uniform changes, the geometry stays where it is
+        COLOUR_SCHEME = 1 - COLOUR_SCHEME;
+        cout << "Colour scheme of parts one to three: " << (COLOUR_SCHEME ? "heat" : "assignment") << endl;
+    }
+    if(key == GLFW_KEY_LEFT && action == GLFW_PRESS)
+    {
+        glClearColor(1.0, 1.0, 1.0, 1.0);
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        // cycle backwards, part one wraps around to the last part
+        if(currentPart() != 0)
+            selectPart(currentPart() == 1 ? PART_COUNT : currentPart() - 1);
+        handleLeftRightKeys();
+    }
+    if(key == GLFW_KEY_RIGHT && action == GLFW_PRESS)
+    {
+        glClearColor(1.0, 1.0, 1.0, 1.0);
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        // cycle forwards, the last part wraps around to part one
+        if(currentPart() != 0)
+            selectPart(currentPart() % PART_COUNT + 1);
+        handleLeftRightKeys();
+    }
+    if(key == GLFW_KEY_UP && action == GLFW_PRESS)
+    {
+        glClearColor(1.0, 1.0, 1.0, 1.0);
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        if(currentPart() != 0)
+            *partLevels(currentPart()) += 1;
+        handleUpDowntKeys();
+    }
+    if(key == GLFW_KEY_DOWN && action == GLFW_PRESS)
+    {
+        glClearColor(1.0, 1.0, 1.0, 1.0);
+        glClear(GL_COLOR_BUFFER_BIT);
 
+        if(currentPart() != 0 && *partLevels(currentPart()) != 0)
+            *partLevels(currentPart()) -= 1;
+        handleUpDowntKeys();
     }
 }
 
-void drawSierpinskiTriangle(int level)
+// orbits the camera around the solids while the left mouse button is held
+void MouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
+{
+    if(button == GLFW_MOUSE_BUTTON_LEFT)
+    {
+        cameraDragging = (action == GLFW_PRESS);
+        glfwGetCursorPos(window, &cameraCursorX, &cameraCursorY);
+    }
+}
+
+void CursorPosCallback(GLFWwindow* window, double x, double y)
 {
-    //draw the main triangle
-    Triangle baseTriangle;
-    baseTriangle.leftLine.startPoint.x = -0.5;
-    baseTriangle.leftLine.startPoint.y = -0.5;
-    baseTriangle.leftLine.endPoint.x = 0;
-    baseTriangle.leftLine.endPoint.y = 0.5;
+    int width, height;
+    glfwGetWindowSize(window, &width, &height);
 
-    baseTriangle.rightLine.startPoint.x = 0;
-    baseTriangle.rightLine.startPoint.y = 0.5;
-    baseTriangle.rightLine.endPoint.x = 0.5;
-    baseTriangle.rightLine.endPoint.y = -0.5;
+    // part three highlights the leaf under the cursor when it is next drawn
+    hoverActive = true;
+    hoverCursorX = 2.0 * x / max(width, 1) - 1.0;
+    hoverCursorY = 1.0 - 2.0 * y / max(height, 1);
 
-    baseTriangle.LowerLine.startPoint.x = 0.5;
-    baseTriangle.LowerLine.startPoint.y = -0.5;
-    baseTriangle.LowerLine.endPoint.x = -0.5;
-    baseTriangle.LowerLine.endPoint.y = -0.5;
+    if(!cameraDragging)
+        return;
+
+    // the zoomable parts are dragged along with the cursor
+    if(viewZoomable())
+    {
+        setView(VIEW_CENTER_X - 2.0 * (x - cameraCursorX) / max(width, 1) / VIEW_ZOOM,
+                VIEW_CENTER_Y + 2.0 * (y - cameraCursorY) / max(height, 1) / VIEW_ZOOM, VIEW_ZOOM);
+        cameraCursorX = x;
+        cameraCursorY = y;
+        handleUpDowntKeys();
+        return;
+    }
 
-    displaySierpinskiTriangle(level, baseTriangle, BASE_TRIANGLE);
+    // a drag across the whole window turns the camera about half a turn
+    CAMERA_YAW += 3.0f * (x - cameraCursorX) / max(width, 1);
+    CAMERA_PITCH += 3.0f * (y - cameraCursorY) / max(height, 1);
+    CAMERA_PITCH = min(max(CAMERA_PITCH, -1.5f), 1.5f);
+
+    cameraCursorX = x;
+    cameraCursorY = y;
 }
 
+void ScrollCallback(GLFWwindow* window, double xoffset, double yoffset)
+{
+    // the zoomable parts zoom around the point under the cursor
+    if(viewZoomable())
+    {
+        int width, height;
+        double x, y;
+        glfwGetWindowSize(window, &width, &height);
+        glfwGetCursorPos(window, &x, &y);
+        zoomView(pow(1.25, yoffset), 2.0 * x / max(width, 1) - 1.0, 1.0 - 2.0 * y / max(height, 1));
+        handleUpDowntKeys();
+        return;
+    }
+
+    CAMERA_DISTANCE = min(max(CAMERA_DISTANCE * (float)pow(0.9, yoffset), 1.2f), 8.0f);
+}
 
 /**
  * ================================================================================================
  *
- * The following code section targets KeyBoard events and their handlers
+ * The following code section targets the command line options and the benchmark mode
  *
  * ================================================================================================
  */
-int PART_ONE_LEVELS = 1;
-int PART_TWO_LEVELS = 1;
-int PART_THREE_LEVELS = 1;
 
-void handleLeftRightKeys(){
-    if(PART_ONE)
+// benchmark frames allowed to allocate before the loop counts as steady
+const size_t ALLOCATION_WARMUP_FRAMES = 5;
+
+struct MyOptions
+{
+    // --export <svg|obj|raw> <file or -> <part> <level>, run before any window opens
+    bool    exportPart;
+    string  exportFormat;
+    string  exportPath;
+
+    // --verify-compute <level> and --verify-builder <level>, zero when not given
+    int     verifyLevel;
+    int     verifyBuilderLevel;
+
+    // --ifs <file> <image> renders an iterated function system without a
+    // window, --samples points over --threads threads
+    string  ifsPath;
+    string  ifsImagePath;
+    uint64_t samples;
+    int     threads;
+
+    // scene shown at startup instead of waiting for the start key, part zero
+    // keeps the usual start screen
+    int     part;
+    int     level;
+    bool    dashboard;
+
+    // --zoom <x> and --center <x>,<y> start parts one and three zoomed in
+    double  zoom;
+    double  centerX;
+    double  centerY;
+
+    // --benchmark renders the scene continuously for a number of frames and
+    // reports the frame times on exit
+    bool    benchmark;
+    int     frames;
+    bool    vsync;
+
+    int     width;
+    int     height;
+
+    // --record <file> logs every key event, --replay <file> plays a log back
+    // in a hidden window at --replay-speed times the recorded pace
+    string  recordPath;
+    string  replayPath;
+    double  replaySpeed;
+
+    // --assert-no-allocations fails the benchmark if its steady state allocates
+    bool    assertNoAllocations;
+
+    // --help only prints the usage, which is not an error
+    bool    help;
+
+    MyOptions() : exportPart(false), verifyLevel(0), verifyBuilderLevel(0), samples(100000000),
+        threads(max(thread::hardware_concurrency(), 1u)), part(0), level(1), dashboard(false),
+        zoom(1), centerX(0), centerY(0), benchmark(false), frames(300), vsync(false), width(512), height(512), replaySpeed(1),
+        assertNoAllocations(false), help(false)
+    {}
+};
+
+void PrintUsage(const char *program)
+{
+    cerr << "usage: " << program << " [options]\n"
+         << "  --part <1-6>          start on the given part instead of the start screen\n"
+         << "  --level <n>           level of the starting part (default 1)\n"
+         << "  --dashboard           start on the dashboard of all parts\n"
+         << "  --zoom <x>            start parts one and three zoomed in x times\n"
+         << "  --center <x>,<y>      world position in the middle of the zoomed window\n"
+         << "  --compute             generate part three with the compute shader\n"
+         << "  --out-of-core         draw part three in chunks\n"
+         << "  --chaos-game          draw part three as a point cloud converging over frames\n"
+         << "  --no-mesh-cache       always generate meshes instead of mapping cached ones\n"
+         << "  --host-budget <MB>    host memory a scene may hold (default 256), larger\n"
+         << "                        levels are drawn in chunks or at a lower level\n"
+         << "  --gpu-budget <MB>     buffer memory a scene may hold (default 256)\n"
+         << "  --size <w>x<h>        window size (default 512x512)\n"
+         << "  --benchmark           render continuously and report frame times on exit\n"
+         << "  --frames <n>          frames to measure in benchmark mode (default 300)\n"
+         << "  --vsync               wait for vertical sync in benchmark mode (default off)\n"
+         << "  --record <file>       log every key event with its time to the file\n"
+         << "  --replay <file>       play a key log back in a hidden window, reporting the\n"
+         << "                        generation time and frame latency of every event\n"
+         << "  --replay-speed <x>    replay x times faster than recorded, 0 for no waiting\n"
+         << "  --assert-no-allocations\n"
+         << "                        benchmark and exit with an error if any frame after the\n"
+         << "                        first few allocates (needs -DTRACK_ALLOCATIONS)\n"
+         << "  --verify-compute <n>  check the compute shader against the CPU at level n\n"
+         << "  --verify-builder <n>  check the threaded builder of part three against the\n"
+         << "                        recursive generator at level n (8 or more)\n"
+         << "  --export <svg|obj|raw> <file or -> <part> <level>\n"
+         << "                        write a part to a file without opening a window\n"
+         << "  --ifs <file.ifs> <image.ppm>\n"
+         << "                        render the density of an iterated function system of\n"
+         << "                        \"a b c d e f p\" maps without opening a window, at --size\n"
+         << "  --samples <n>         points of the --ifs image (default 100000000)\n"
+         << "  --threads <n>         threads of the --ifs image and of the CPU generators\n"
+         << "                        (default all cores)" << endl;
+}
+
+/**
+ * @brief ParseOptions
+ * Fills in the options from the command line, switching the part three
+ * backends and the mesh cache directly.
+ * @return false after printing the usage if an option is unknown or invalid,
+ * --help prints it too but returns true with help set
+ */
+bool ParseOptions(int argc, char *argv[], MyOptions *options)
+{
+    for (int i = 1; i < argc; i++)
     {
-        renderSquaresAndDiamonds(1);
-        PART_TWO_LEVELS = 1;
-        PART_THREE_LEVELS = 1;
+        string option = argv[i];
+
+        // number of values the option takes
+        int values = 0;
+        if (option == "--part" || option == "--level" || option == "--size"
+            || option == "--frames" || option == "--verify-compute" || option == "--verify-builder"
+            || option == "--record" || option == "--replay" || option == "--replay-speed" || option == "--zoom"
+            || option == "--center" || option == "--host-budget" || option == "--gpu-budget"
+            || option == "--samples" || option == "--threads")
+            values = 1;
+        else if (option == "--ifs")
+            values = 2;
+        else if (option == "--export")
+            values = 4;
+
+        if (i + values >= argc)
+        {
+            cerr << "ERROR: " << option << " needs " << values << " value(s)" << endl;
+            PrintUsage(argv[0]);
+            return false;
+        }
+
+        bool valid = true;
+        if (option == "--part")
+        {
+            options->part = atoi(argv[i + 1]);
+            valid = options->part >= 1 && options->part <= PART_COUNT;
+        }
+        else if (option == "--level")
+        {
+            options->level = atoi(argv[i + 1]);
+            valid = options->level >= 1;
+        }
+        else if (option == "--zoom")
+        {
+            options->zoom = atof(argv[i + 1]);
+            valid = options->zoom >= 1 && options->zoom <= VIEW_MAX_ZOOM;
+        }
+        else if (option == "--host-budget" || option == "--gpu-budget")
+        {
+            int megabytes = atoi(argv[i + 1]);
+            valid = megabytes >= 1;
+            if (valid)
+                (option == "--host-budget" ? HOST_MEMORY_BUDGET : GPU_MEMORY_BUDGET) = (uint64_t)megabytes << 20;
+        }
+        else if (option == "--center")
+            valid = sscanf(argv[i + 1], "%lf,%lf", &options->centerX, &options->centerY) == 2;
+        else if (option == "--size")
+            valid = sscanf(argv[i + 1], "%dx%d", &options->width, &options->height) == 2
+                    && options->width > 0 && options->height > 0;
+        else if (option == "--frames")
+        {
+            options->frames = atoi(argv[i + 1]);
+            valid = options->frames >= 1;
+        }
+        else if (option == "--verify-compute")
+        {
+            options->verifyLevel = atoi(argv[i + 1]);
+            valid = options->verifyLevel >= 1;
+        }
+        else if (option == "--verify-builder")
+        {
+            options->verifyBuilderLevel = atoi(argv[i + 1]);
+            valid = options->verifyBuilderLevel > SIERPINSKI_TABLE_LEVELS;
+        }
+        else if (option == "--ifs")
+        {
+            options->ifsPath = argv[i + 1];
+            options->ifsImagePath = argv[i + 2];
+        }
+        else if (option == "--samples")
+        {
+            options->samples = strtoull(argv[i + 1], NULL, 10);
+            valid = options->samples >= 1;
+        }
+        else if (option == "--threads")
+        {
+            options->threads = atoi(argv[i + 1]);
+            valid = options->threads >= 1;
+            if (valid)
+                WORKER_THREADS = options->threads;
+        }
+        else if (option == "--record")
+            options->recordPath = argv[i + 1];
+        else if (option == "--replay")
+            options->replayPath = argv[i + 1];
+        else if (option == "--replay-speed")
+        {
+            options->replaySpeed = atof(argv[i + 1]);
+            valid = options->replaySpeed >= 0;
+        }
+        else if (option == "--export")
+        {
+            options->exportPart = true;
+            options->exportFormat = argv[i + 1];
+            options->exportPath = argv[i + 2];
+            options->part = atoi(argv[i + 3]);
+            options->level = atoi(argv[i + 4]);
+        }
+        else if (option == "--dashboard")
+            options->dashboard = true;
+        else if (option == "--compute")
+            COMPUTE_SIERPINSKI = true;
+        else if (option == "--out-of-core")
+            OUT_OF_CORE = true;
+        else if (option == "--chaos-game")
+            CHAOS_GAME = true;
+        else if (option == "--no-mesh-cache")
+            MESH_CACHE = false;
+        else if (option == "--benchmark")
+            options->benchmark = true;
+        else if (option == "--vsync")
+            options->vsync = true;
+        else if (option == "--assert-no-allocations")
+        {
+            if (!ALLOCATION_TRACKING)
+            {
+                cerr << "ERROR: " << option << " needs a build with -DTRACK_ALLOCATIONS" << endl;
+                return false;
+            }
+            options->assertNoAllocations = true;
+            options->benchmark = true;
+        }
+        else if (option == "--help")
+        {
+            PrintUsage(argv[0]);
+            options->help = true;
+            return true;
+        }
+        else
+        {
+            cerr << "ERROR: Unknown option " << option << endl;
+            PrintUsage(argv[0]);
+            return false;
+        }
+
+        if (!valid)
+        {
+            cerr << "ERROR: Invalid value " << argv[i + 1] << " for " << option << endl;
+            PrintUsage(argv[0]);
+            return false;
+        }
+        i += values;
     }
-    else if(PART_TWO)
+
+    // a benchmark needs something to draw
+    if (options->benchmark && options->part == 0 && !options->dashboard)
+        options->part = 1;
+    return true;
+}
+
+/**
+ * @brief StartScene
+ * Shows the part and level of the options as if they had been reached with
+ * the keyboard.
+ */
+void StartScene(const MyOptions &options)
+{
+    if (options.part == 0 && !options.dashboard)
+        return;
+
+    // the compute backend depends on what the context turned out to support
+    COMPUTE_SIERPINSKI = COMPUTE_SIERPINSKI && computeShaderSupported;
+
+    glClearColor(1.0, 1.0, 1.0, 1.0);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    selectPart(max(options.part, 1));
+    for (int part = 1; part <= PART_COUNT; part++)
+        *partLevels(part) = 1;
+
+    if (options.dashboard && multiDrawIndirectSupported)
     {
-        doPartTwo(1);
-        PART_ONE_LEVELS = 1;
-        PART_THREE_LEVELS = 1;
+        PART_ONE_LEVELS = PART_TWO_LEVELS = PART_THREE_LEVELS = options.level;
+        DASHBOARD = true;
+        dashboardChanged = true;
+        return;
     }
-    else if(PART_THREE)
-    {
-        drawSierpinskiTriangle(1);
-        nextRColor = 0.4f;
-        nextGColor = 0.4f;
-        nextBColor = 0.4f;
+    if (options.dashboard)
+        cout << "Multi-draw-indirect is not supported by this OpenGL context" << endl;
 
-        PART_ONE_LEVELS = 1;
-        PART_TWO_LEVELS = 1;
-    }
+    *partLevels(currentPart()) = options.level;
+    if (viewZoomable())
+        setView(options.centerX, options.centerY, options.zoom);
+    handleUpDowntKeys();
 }
 
-void handleUpDowntKeys(){
-    if(PART_ONE)
+/**
+ * @brief percentile
+ * @param sorted frame times in ascending order
+ * @return the nearest-rank percentile p (0 to 100) of the frame times
+ */
+double percentile(const vector<double> &sorted, double p)
+{
+    size_t rank = (size_t)ceil(p / 100.0 * sorted.size());
+    return sorted[min(max(rank, (size_t)1), sorted.size()) - 1];
+}
+
+// prints the frame time distribution and the generation and upload totals
+void ReportBenchmark(const MyOptions &options, vector<double> frameTimes, double firstFrame)
+{
+    sort(frameTimes.begin(), frameTimes.end());
+
+    double total = 0;
+    for (size_t i = 0; i < frameTimes.size(); i++)
+        total += frameTimes[i];
+    double mean = total / max(frameTimes.size(), (size_t)1);
+
+    // the level as drawn, after clamping to the limits of the part
+    cout << "Benchmark: ";
+    if (DASHBOARD)
+        cout << "dashboard level " << PART_ONE_LEVELS;
+    else
+        cout << "part " << currentPart() << " level " << *partLevels(currentPart());
+    cout
+         << (COMPUTE_SIERPINSKI ? ", compute" : "") << (OUT_OF_CORE ? ", out-of-core" : "")
+         << (CHAOS_GAME ? ", chaos game" : "")
+         << (MESH_CACHE ? "" : ", no mesh cache") << ", " << options.width << "x" << options.height
+         << ", vsync " << (options.vsync ? "on" : "off") << endl;
+    cout << "  Renderer:         " << glDriverDescription << endl;
+    cout << "  First frame:      " << firstFrame << " ms" << endl;
+    if (!frameTimes.empty())
     {
-        if(PART_ONE_LEVELS > 0){
-            renderSquaresAndDiamonds(PART_ONE_LEVELS);
-        } else{
-            PART_ONE_LEVELS = 1;
-            renderSquaresAndDiamonds(PART_ONE_LEVELS);
-        }
+        cout << "  Frame time (ms):  min " << frameTimes.front() << ", mean " << mean
+             << ", p50 " << percentile(frameTimes, 50) << ", p95 " << percentile(frameTimes, 95)
+             << ", p99 " << percentile(frameTimes, 99) << " over " << frameTimes.size()
+             << " frames (" << 1000.0 / mean << " fps)" << endl;
     }
-    else if(PART_TWO)
+    cout << "  Generation:       " << renderStats.generationMilliseconds << " ms" << endl;
+
+    double megabytes = renderStats.uploadBytes / (1024.0 * 1024.0);
+    cout << "  Upload:           " << megabytes << " MB in " << renderStats.uploadMilliseconds << " ms";
+    if (renderStats.uploadMilliseconds > 0)
+        cout << " (" << megabytes / (renderStats.uploadMilliseconds / 1000.0) << " MB/s)";
+    cout << endl;
+    cout << "  Peak geometry:    host " << renderStats.peakHostBytes / (1024.0 * 1024.0) << " MB, GPU "
+         << renderStats.peakGpuBytes / (1024.0 * 1024.0) << " MB (budgets "
+         << HOST_MEMORY_BUDGET / (1024 * 1024) << " and " << GPU_MEMORY_BUDGET / (1024 * 1024) << " MB)" << endl;
+}
+
+struct MyKeyReplay
+{
+    vector<KeyLogEvent> events;
+    size_t  next;
+
+    // 1 replays with the recorded timing, 2 twice as fast, and so on, while
+    // 0 plays each event as soon as the frame of the previous one is done
+    double  speed;
+
+    // recorded time of the next event since the start, in microseconds
+    uint64_t due;
+    chrono::steady_clock::time_point start;
+
+    // the event being handled in the current frame
+    bool    pending;
+    chrono::steady_clock::time_point eventStart;
+    double  generationStart;
+
+    // generation and key-to-frame latency of every event, in milliseconds
+    vector<double> generationTimes;
+    vector<double> frameLatencies;
+
+    MyKeyReplay() : next(0), speed(1), due(0), pending(false), generationStart(0)
+    {}
+};
+
+// loads the key log and starts its clock, returning true if successful
+bool OpenKeyReplay(MyKeyReplay *replay, const string &path, double speed)
+{
+    if (!LoadKeyLog(path, replay->events))
+        return false;
+
+    replay->next = 0;
+    replay->speed = speed;
+    replay->due = replay->events.empty() ? 0 : replay->events[0].delay;
+    replay->start = chrono::steady_clock::now();
+    cout << "Replaying " << replay->events.size() << " key events from " << path << endl;
+    return true;
+}
+
+bool KeyReplayFinished(const MyKeyReplay *replay)
+{
+    return replay->next >= replay->events.size() && !replay->pending;
+}
+
+/**
+ * @brief BeginReplayedEvent
+ * Sleeps until the next event is due and hands it to the key callback, just
+ * as glfwWaitEvents() would have.
+ */
+void BeginReplayedEvent(MyKeyReplay *replay, GLFWwindow *window)
+{
+    if (replay->next >= replay->events.size())
+        return;
+
+    if (replay->speed > 0)
     {
-        if(PART_TWO_LEVELS > 0){
-            doPartTwo(PART_TWO_LEVELS);
-        } else{
-            PART_TWO_LEVELS = 1;
-            doPartTwo(PART_TWO_LEVELS);
-        }
+        chrono::duration<double, micro> elapsed = chrono::steady_clock::now() - replay->start;
+        double wait = replay->due / replay->speed - elapsed.count();
+        if (wait > 0)
+            usleep((useconds_t)wait);
     }
-    else if(PART_THREE)
-    {
-        if(PART_THREE_LEVELS > 0){
-            drawSierpinskiTriangle(PART_THREE_LEVELS);
-        } else{
-            PART_THREE_LEVELS = 1;
-            drawSierpinskiTriangle(PART_THREE_LEVELS);
-        }
 
-        nextRColor = 0.4f;
-        nextGColor = 0.4f;
-        nextBColor = 0.4f;
-    }
+    const KeyLogEvent &event = replay->events[replay->next];
+    replay->pending = true;
+    replay->eventStart = chrono::steady_clock::now();
+    replay->generationStart = renderStats.generationMilliseconds;
+    KeyCallback(window, event.key, event.scancode, event.action, event.mods);
+}
+
+/**
+ * @brief EndReplayedEvent
+ * Waits for the frame drawn after the event and reports how long the event
+ * took to show up on screen, and how much of it was spent generating.
+ */
+void EndReplayedEvent(MyKeyReplay *replay)
+{
+    if (!replay->pending)
+        return;
+
+    glFinish();
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+    chrono::duration<double, milli> latency = now - replay->eventStart;
+    chrono::duration<double> at = replay->eventStart - replay->start;
+    double generation = renderStats.generationMilliseconds - replay->generationStart;
+
+    const KeyLogEvent &event = replay->events[replay->next];
+    const char *ACTIONS[] = { "release", "press", "repeat" };
+    cout << "Replay event " << replay->next << " (key " << event.key << " "
+         << ACTIONS[min((int)event.action, 2)] << ") at " << at.count() << " s: generation "
+         << generation << " ms, frame " << latency.count() << " ms" << endl;
+
+    replay->generationTimes.push_back(generation);
+    replay->frameLatencies.push_back(latency.count());
+    replay->pending = false;
+    replay->next++;
+    if (replay->next < replay->events.size())
+        replay->due += replay->events[replay->next].delay;
 }
 
-void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
+// prints the totals and the latency distribution over all replayed events
+void ReportKeyReplay(const MyKeyReplay &replay)
 {
-    if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
-        glfwSetWindowShouldClose(window, GL_TRUE);
-
-    if(key == GLFW_KEY_S && action == GLFW_PRESS)
-    {
-        glClearColor(1.0, 1.0, 1.0, 1.0);
-        glClear(GL_COLOR_BUFFER_BIT);
-        PART_ONE = true;
-        handleLeftRightKeys();
-    }
-    if(key == GLFW_KEY_LEFT && action == GLFW_PRESS)
-    {
-        glClearColor(1.0, 1.0, 1.0, 1.0);
-        glClear(GL_COLOR_BUFFER_BIT);
+    if (replay.frameLatencies.empty())
+        return;
 
-        if(PART_ONE == true)
-        {
-            PART_ONE = false;
-            PART_TWO = false;
-            PART_THREE = true;
-        }
-        else if(PART_TWO == true)
-        {
-            PART_ONE = true;
-            PART_TWO = false;
-            PART_THREE = false;
-        }
-        else if(PART_THREE == true)
-        {
-            PART_ONE = false;
-            PART_TWO = true;
-            PART_THREE = false;
-        }
-        handleLeftRightKeys();
-    }
-    if(key == GLFW_KEY_RIGHT && action == GLFW_PRESS)
-    {
-        glClearColor(1.0, 1.0, 1.0, 1.0);
-        glClear(GL_COLOR_BUFFER_BIT);
+    vector<double> sorted = replay.frameLatencies;
+    sort(sorted.begin(), sorted.end());
 
-        if(PART_ONE == true)
-        {
-            PART_ONE = false;
-            PART_TWO = true;
-            PART_THREE = false;
-        }
-        else if(PART_TWO == true)
-        {
-            PART_ONE = false;
-            PART_TWO = false;
-            PART_THREE = true;
-        }
-        else if(PART_THREE == true)
-        {
-            PART_ONE = true;
-            PART_TWO = false;
-            PART_THREE = false;
-        }
-        handleLeftRightKeys();
-    }
-    if(key == GLFW_KEY_UP && action == GLFW_PRESS)
+    double generation = 0, latency = 0;
+    for (size_t i = 0; i < sorted.size(); i++)
     {
-        glClearColor(1.0, 1.0, 1.0, 1.0);
-        glClear(GL_COLOR_BUFFER_BIT);
-
-        if(PART_ONE)
-        {
-            PART_ONE_LEVELS += 1;
-        }
-        else if(PART_TWO)
-        {
-            PART_TWO_LEVELS += 1;
-        } else if(PART_THREE)
-        {
-            PART_THREE_LEVELS += 1;
-        }
-        handleUpDowntKeys();
+        generation += replay.generationTimes[i];
+        latency += replay.frameLatencies[i];
     }
-    if(key == GLFW_KEY_DOWN && action == GLFW_PRESS)
-    {
-        glClearColor(1.0, 1.0, 1.0, 1.0);
-        glClear(GL_COLOR_BUFFER_BIT);
 
-        if(PART_ONE)
-        {
-            if(PART_ONE_LEVELS != 0)
-                PART_ONE_LEVELS -= 1;
-        }
-        else if(PART_TWO)
-        {
-            if(PART_TWO_LEVELS != 0)
-                PART_TWO_LEVELS -= 1;
-        } else if(PART_THREE)
-        {
-            if(PART_THREE_LEVELS != 0)
-                PART_THREE_LEVELS -= 1;
-        }
-        handleUpDowntKeys();
-    }
+    cout << "Replayed " << sorted.size() << " key events";
+    if (replay.speed > 0)
+        cout << " at " << replay.speed << "x the recorded pace" << endl;
+    else
+        cout << " back to back" << endl;
+    cout << "  Generation:       " << generation << " ms" << endl;
+    cout << "  Frame latency:    mean " << latency / sorted.size() << ", p50 " << percentile(sorted, 50)
+         << ", p95 " << percentile(sorted, 95) << ", max " << sorted.back() << " ms" << endl;
 }
 
 
@@ -747,37 +5511,190 @@ void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
  */
 
 
-void RenderScene(MyGeometry *geometry, MyShader *shader)
+void RenderScene(MyGeometry *geometry, MyShader *shader, MySquares *squares, MySpiral *spiral,
+                 MyComputeGeometry *compute, MyChunkedGeometry *chunked, MyChaosGame *chaos,
+                 MyHighlight *highlight, MyCarpet *carpet, MySolid *solid, MyDashboard *dashboard)
 {
+    // the dashboard replaces the single part view entirely
+    if(DASHBOARD)
+    {
+        RenderDashboard(dashboard);
+#ifndef NDEBUG
+        CheckGLErrors();
+#endif
+        return;
+    }
+
+    // the whole of part one is a single unit square drawn many times
+    if(PART_ONE && !ViewIsZoomed())
+    {
+        RenderSquares(squares);
+#ifndef NDEBUG
+        CheckGLErrors();
+#endif
+        return;
+    }
+
+    // the spiral has no buffers at all
+    if(PART_TWO)
+    {
+        RenderSpiral(spiral);
+#ifndef NDEBUG
+        CheckGLErrors();
+#endif
+        return;
+    }
+
+    // the point cloud of part three has no geometry at all
+    if(PART_THREE && CHAOS_GAME)
+    {
+        RenderChaosGame(chaos);
+        glUseProgram(shader->program);
+        RenderHighlight(highlight, shader);
+        glUseProgram(0);
+#ifndef NDEBUG
+        CheckGLErrors();
+#endif
+        return;
+    }
+
+    // the carpet has its own instanced shader and buffers
+    if(PART_FOUR)
+    {
+        RenderCarpet(carpet);
+#ifndef NDEBUG
+        CheckGLErrors();
+#endif
+        return;
+    }
+
+    // the 3D solids have a camera, a depth buffer and indexed meshes
+    if(PART_FIVE || PART_SIX)
+    {
+        RenderSolid(solid);
+#ifndef NDEBUG
+        CheckGLErrors();
+#endif
+        return;
+    }
+
     // bind our shader program and the vertex array object containing our
     // scene geometry, then tell OpenGL to draw our geometry
     glUseProgram(shader->program);
 
-    //buffer vertex data
-    glBindVertexArray(geometry->vertexArray);
-    glBindBuffer(GL_ARRAY_BUFFER, geometry->vertexBuffer);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(float)*vertices.size(), &vertices[0]);
+    // part one is coloured from the vertex index alone
+    int colourRule = PART_ONE ? COLOUR_NESTED_SQUARES : COLOUR_FROM_ATTRIBUTE;
+    float colourExtent = PART_ONE_LEVELS;
+    glUniform1i(glGetUniformLocation(shader->program, "ColourRule"), colourRule);
+    glUniform1i(glGetUniformLocation(shader->program, "ColourScheme"), COLOUR_SCHEME);
+    glUniform1f(glGetUniformLocation(shader->program, "ColourExtent"), colourExtent);
+
+    // part three generated by the compute backend is already in GPU buffers,
+    // levels too large to hold are streamed through in chunks, and levels
+    // finer than a pixel are drawn at the deepest level that is not
+    int partThreeLevel = sierpinskiDrawnLevel(PART_THREE_LEVELS);
+    if(PART_THREE && !UseComputeSierpinski(partThreeLevel)
+       && UseOutOfCoreSierpinski(partThreeLevel))
+    {
+        RenderOutOfCoreSierpinski(chunked, partThreeLevel);
+    }
+    else if(PART_THREE && UseComputeSierpinski(partThreeLevel))
+    {
+        if(compute->level != partThreeLevel)
+        {
+            // wait for the dispatch so that its time is counted as generation
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            GenerateSierpinskiOnGPU(compute, partThreeLevel);
+            glFinish();
+            noteMemoryUse(0, sceneSize(3, partThreeLevel).bytes);
+            chrono::duration<double, milli> generation = chrono::steady_clock::now() - start;
+            renderStats.generationMilliseconds += generation.count();
+
+            glUseProgram(shader->program);
+        }
 
-    //buffer color data
-    glBindBuffer(GL_ARRAY_BUFFER, geometry->colourBuffer);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(float)*colors.size(), &colors[0]);
+        glBindVertexArray(compute->vertexArray);
+        glDrawArrays(GL_TRIANGLES, 0, compute->elementCount);
+    }
+    else
+    {
+        // upload only when the part or level changed, a cached mesh goes
+        // straight from its mapped pages into the buffer
+        if(geometryChanged)
+        {
+            const float *positionData = vertices.data();
+            const float *colourData = colors.data();
+            uint64_t vertexCount = vertices.size() / 2;
+            if(mappedMesh.base)
+            {
+                positionData = mappedMesh.positions;
+                colourData = mappedMesh.colours;
+                vertexCount = mappedMesh.vertexCount;
+            }
+            else if(staticMesh.positions)
+            {
+                positionData = staticMesh.positions;
+                colourData = staticMesh.colours;
+                vertexCount = staticMesh.vertexCount;
+            }
+
+            //buffer vertex data
+            glBindBuffer(GL_ARRAY_BUFFER, geometry->vertexBuffer);
+            UploadBufferData(GL_ARRAY_BUFFER, sizeof(float)*2*vertexCount, positionData, GL_STATIC_DRAW);
+
+            //buffer color data, only part three has any
+            bool vertexColours = colourRule == COLOUR_FROM_ATTRIBUTE;
+            uint64_t bytes = (vertexColours ? 5 : 2) * sizeof(float) * vertexCount;
+            noteMemoryUse(bytes, bytes);
+            glBindBuffer(GL_ARRAY_BUFFER, geometry->colourBuffer);
+            UploadBufferData(GL_ARRAY_BUFFER, vertexColours ? sizeof(float)*3*vertexCount : 0,
+                             vertexColours ? colourData : NULL, GL_STATIC_DRAW);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+            glBindVertexArray(geometry->vertexArray);
+            if (vertexColours)
+                glEnableVertexAttribArray(1);
+            else
+                glDisableVertexAttribArray(1);
+
+            geometry->elementCount = vertexCount;
+            geometry->instanceCount = geometryInThirds ? 3 : 1;
+            geometryChanged = false;
+
+            // the GPU has its own copy now, so give the host memory back
+            ReleaseMeshCache();
+            staticMesh = StaticMesh();
+            FloatBuffer().swap(vertices);
+            FloatBuffer().swap(colors);
+        }
 
-    //draw and clear
-    if(PART_ONE || PART_TWO)
-       glDrawArrays(GL_LINES, 0, vertices.size()/2);
+        //draw
+        glBindVertexArray(geometry->vertexArray);
+        if(PART_ONE)
+           glDrawArrays(GL_LINES, 0, geometry->elementCount);
 
-    if(PART_THREE)
-        glDrawArrays(GL_TRIANGLES, 0, vertices.size()/2);
+        if(PART_THREE)
+        {
+            // one third drawn as all three, moved and tinted per instance
+            if(geometry->instanceCount > 1)
+                glUniform1i(glGetUniformLocation(shader->program, "ColourRule"), COLOUR_TINTED_INSTANCE);
+            glDrawArraysInstanced(GL_TRIANGLES, 0, geometry->elementCount, geometry->instanceCount);
+        }
+    }
 
-    vertices.clear();
-    colors.clear();
+    // the leaf under the cursor is highlighted over whichever backend drew part three
+    if(PART_THREE)
+        RenderHighlight(highlight, shader);
 
     // reset state to default (no shader or geometry bound)
     glBindVertexArray(0);
     glUseProgram(0);
 
-    // check for and report any OpenGL errors
+#ifndef NDEBUG
+    // check for and report any OpenGL errors, this is only a flag test when
+    // debug output is active, and release builds skip the per-frame check
     CheckGLErrors();
+#endif
 }
 
 // --------------------------------------------------------------------------
@@ -795,9 +5712,53 @@ void ErrorCallback(int error, const char* description)
 
 int main(int argc, char *argv[])
 {
+    // remember when we started so the time to the first frame can be reported
+    chrono::steady_clock::time_point launchTime = chrono::steady_clock::now();
+    bool firstFrame = true;
+
+    MyOptions options;
+    if (!ParseOptions(argc, argv, &options))
+        return -1;
+    if (options.help)
+        return 0;
+
+    // --export streams a part to a file (or stdout) and exits without
+    // opening a window
+    if (options.exportPart)
+    {
+        bool ok = exportPart(options.exportFormat, options.exportPath, options.part, options.level);
+        PrintAllocationSummary();
+        return ok ? 0 : 1;
+    }
+
+    // --ifs renders an image on the CPU alone
+    if (!options.ifsPath.empty())
+    {
+        bool ok = renderIteratedFunctionSystem(options.ifsPath, options.ifsImagePath, options.samples,
+                                               options.threads, options.width, options.height);
+        PrintAllocationSummary();
+        return ok ? 0 : 1;
+    }
+
+    // --verify-builder holds the level twice, once from each generator
+    if (options.verifyBuilderLevel > 0)
+    {
+        if (!fitsMemoryBudget(sceneSize(3, options.verifyBuilderLevel), HOST_MEMORY_BUDGET / 2))
+        {
+            cerr << "ERROR: level " << options.verifyBuilderLevel
+                 << " is too large to verify within the host memory budget" << endl;
+            return 1;
+        }
+        bool match = verifySierpinskiBuilder(options.verifyBuilderLevel);
+        PrintAllocationSummary();
+        return match ? 0 : 1;
+    }
+
     // initialize the GLFW windowing system
     if (!glfwInit()) {
         cout << "ERROR: GLFW failed to initilize, TERMINATING" << endl;
+        if (!options.replayPath.empty())
+            cout << "A replay still needs a display, on a machine without one run it under xvfb-run" << endl;
         return -1;
     }
     glfwSetErrorCallback(ErrorCallback);
@@ -808,20 +5769,37 @@ int main(int argc, char *argv[])
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-    window = glfwCreateWindow(512, 512, "CPSC 453 OpenGL Boilerplate", 0, 0);
+#ifndef NDEBUG
+    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE);
+#endif
+    glfwWindowHint(GLFW_DEPTH_BITS, 24);
+
+    // a replay needs no one watching, so keep its window hidden, GLFW still
+    // needs a display to create the window and its context on
+    if (!options.replayPath.empty())
+        glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+    window = glfwCreateWindow(options.width, options.height, "CPSC 453 OpenGL Boilerplate", 0, 0);
     if (!window) {
         cout << "Program failed to create GLFW window, TERMINATING" << endl;
+        if (!options.replayPath.empty())
+            cout << "A replay still needs a display, on a machine without one run it under xvfb-run" << endl;
         glfwTerminate();
         return -1;
     }
 
     // set keyboard callback function and make our context current (active)
     glfwSetKeyCallback(window, KeyCallback);
+    glfwSetMouseButtonCallback(window, MouseButtonCallback);
+    glfwSetCursorPosCallback(window, CursorPosCallback);
+    glfwSetScrollCallback(window, ScrollCallback);
     glfwMakeContextCurrent(window);
 
     // query and print out information about our OpenGL environment
     QueryGLVersion();
 
+    // route OpenGL errors through KHR_debug when the context supports it
+    InitializeDebugOutput();
+
     // call function to load and compile shader programs
     MyShader shader;
     if (!InitializeShaders(&shader)) {
@@ -834,26 +5812,201 @@ int main(int argc, char *argv[])
     if (!InitializeGeometry(&geometry))
         cout << "Program failed to intialize geometry!" << endl;
 
-    // run an event-triggered main loop
+    // instanced unit square of the nested squares in part one
+    MySquares squares;
+    if (!InitializeSquares(&squares))
+        cout << "Program failed to intialize the squares!" << endl;
+
+    // attribute-less line strip of the spiral in part two
+    MySpiral spiral;
+    if (!InitializeSpiral(&spiral))
+        cout << "Program failed to intialize the spiral!" << endl;
+
+    // optional compute shader backend for part three
+    MyComputeGeometry compute;
+    InitializeComputeGeometry(&compute);
+
+    // recycled chunk buffers for levels of part three too large to hold
+    MyChunkedGeometry chunked;
+    InitializeChunkedGeometry(&chunked);
+
+    // point cloud of part three accumulated over the frames
+    MyChaosGame chaos;
+    if (!InitializeChaosGame(&chaos))
+        cout << "Program failed to intialize the chaos game!" << endl;
+
+    // the leaf of part three under the cursor
+    MyHighlight highlight;
+    if (!InitializeHighlight(&highlight))
+        cout << "Program failed to intialize the highlight!" << endl;
+
+    // instanced squares of the Sierpinski carpet in part four
+    MyCarpet carpet;
+    if (!InitializeCarpet(&carpet))
+        cout << "Program failed to intialize the carpet!" << endl;
+
+    // indexed meshes of the 3D solids in parts five and six
+    MySolid solid;
+    if (!InitializeSolid(&solid))
+        cout << "Program failed to intialize the solids!" << endl;
+
+    // split-screen view of all parts drawn with multi-draw-indirect
+    MyDashboard dashboard;
+    InitializeDashboard(&dashboard);
+
+    // --verify-compute <level> checks the GPU generator against the CPU one
+    // and exits, so the backend can be tested without a window system
+    if (options.verifyLevel > 0)
+    {
+        bool match = computeShaderSupported && VerifySierpinskiOnGPU(&compute, options.verifyLevel);
+        if (!computeShaderSupported)
+            cout << "Compute shaders are not supported, nothing to verify" << endl;
+        DestroyDashboard(&dashboard);
+        DestroySolid(&solid);
+        DestroyCarpet(&carpet);
+        DestroyHighlight(&highlight);
+        DestroyChaosGame(&chaos);
+        DestroyChunkedGeometry(&chunked);
+        DestroyComputeGeometry(&compute);
+        DestroySpiral(&spiral);
+        DestroySquares(&squares);
+        DestroyGeometry(&geometry);
+        DestroyShaders(&shader);
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return match ? 0 : 1;
+    }
+
+    // initialization is done, let the driver report messages asynchronously
+    BeginAsynchronousDebugOutput();
+
+    // show the part asked for on the command line, if any
+    StartScene(options);
+
+    // key events are logged from here on, or played back from a log
+    if (!options.recordPath.empty() && !OpenKeyRecorder(&keyRecorder, options.recordPath))
+        glfwSetWindowShouldClose(window, GL_TRUE);
+
+    MyKeyReplay replay;
+    bool replaying = !options.replayPath.empty();
+    if (replaying && !OpenKeyReplay(&replay, options.replayPath, options.replaySpeed))
+        glfwSetWindowShouldClose(window, GL_TRUE);
+
+    // the benchmark never waits for vertical sync unless asked to
+    if (options.benchmark)
+        glfwSwapInterval(options.vsync ? 1 : 0);
+
+    // time between consecutive buffer swaps after the first frame
+    vector<double> frameTimes;
+    double firstFrameTime = 0;
+    uint64_t steadyAllocations = 0;
+    chrono::steady_clock::time_point lastSwap = chrono::steady_clock::now();
+
+    // run an event-triggered main loop, or a continuous one when benchmarking
+    // or replaying
     while (!glfwWindowShouldClose(window))
     {
-        // call function to draw our scene
-        RenderScene(&geometry, &shader);
+        // the frame after startup and after every replayed event shows that event
+        if (replaying && !firstFrame)
+            BeginReplayedEvent(&replay, window);
+
+        // every benchmark frame draws the whole scene from scratch
+        if (options.benchmark)
+        {
+            glClearColor(1.0, 1.0, 1.0, 1.0);
+            glClear(GL_COLOR_BUFFER_BIT);
+        }
+
+        uint64_t frameAllocations = AllocationCount();
+        {
+            AllocationScope allocations("frame");
+
+            // call function to draw our scene
+            RenderScene(&geometry, &shader, &squares, &spiral, &compute, &chunked, &chaos, &highlight,
+                        &carpet, &solid, &dashboard);
+
+            // scene is rendered to the back buffer, so swap to front for display
+            glfwSwapBuffers(window);
+        }
+        frameAllocations = AllocationCount() - frameAllocations;
+
+        if (firstFrame)
+        {
+            glFinish();
+            chrono::steady_clock::time_point now = chrono::steady_clock::now();
+            chrono::duration<double, milli> startup = now - launchTime;
+            chrono::duration<double, milli> frame = now - lastSwap;
+            cout << "Startup to first frame: " << startup.count() << " ms (shader program "
+                 << (shader.fromCache ? "loaded from cache" : "compiled from source") << ")" << endl;
+            firstFrameTime = frame.count();
+            lastSwap = now;
+            firstFrame = false;
+        }
+        else if (options.benchmark)
+        {
+            chrono::steady_clock::time_point now = chrono::steady_clock::now();
+            chrono::duration<double, milli> frame = now - lastSwap;
+            frameTimes.push_back(frame.count());
+            lastSwap = now;
 
-        // scene is rendered to the back buffer, so swap to front for display
-        glfwSwapBuffers(window);
+            // the first frames may still fill caches and grow buffers
+            if (frameTimes.size() > ALLOCATION_WARMUP_FRAMES)
+                steadyAllocations += frameAllocations;
 
-        // sleep until next event before drawing again
-        glfwWaitEvents();
+            if ((int)frameTimes.size() >= options.frames)
+                glfwSetWindowShouldClose(window, GL_TRUE);
+        }
+
+        // report the replayed event once the frame showing it is done
+        if (replaying)
+        {
+            EndReplayedEvent(&replay);
+            if (KeyReplayFinished(&replay))
+                glfwSetWindowShouldClose(window, GL_TRUE);
+        }
+
+        // sleep until next event before drawing again, the benchmark and a
+        // converging point cloud only handle the events already waiting and a
+        // replay sleeps on its own
+        if (options.benchmark || replaying || ChaosGameConverging(&chaos))
+            glfwPollEvents();
+        else
+            glfwWaitEvents();
     }
 
+    if (options.benchmark)
+        ReportBenchmark(options, frameTimes, firstFrameTime);
+    if (options.benchmark && ALLOCATION_TRACKING)
+        cout << "  Steady allocations: " << steadyAllocations << " after the first "
+             << ALLOCATION_WARMUP_FRAMES << " frames" << endl;
+    if (replaying)
+        ReportKeyReplay(replay);
+    CloseKeyRecorder(&keyRecorder);
+
     // clean up allocated resources before exit
+    ReleaseMeshCache();
+    DestroyDashboard(&dashboard);
+    DestroySolid(&solid);
+    DestroyCarpet(&carpet);
+    DestroyHighlight(&highlight);
+    DestroyChaosGame(&chaos);
+    DestroyChunkedGeometry(&chunked);
+    DestroyComputeGeometry(&compute);
+    DestroySpiral(&spiral);
+    DestroySquares(&squares);
     DestroyGeometry(&geometry);
     DestroyShaders(&shader);
     glfwDestroyWindow(window);
     glfwTerminate();
 
+    PrintAllocationSummary();
+
     cout << "Goodbye!" << endl;
+    if (options.assertNoAllocations && steadyAllocations > 0)
+    {
+        cout << "ERROR: The render loop allocated " << steadyAllocations << " times after warming up" << endl;
+        return 1;
+    }
     return 0;
 }
 
@@ -869,14 +6022,175 @@ void QueryGLVersion()
     string version  = reinterpret_cast<const char *>(glGetString(GL_VERSION));
     string glslver  = reinterpret_cast<const char *>(glGetString(GL_SHADING_LANGUAGE_VERSION));
     string renderer = reinterpret_cast<const char *>(glGetString(GL_RENDERER));
+    string vendor   = reinterpret_cast<const char *>(glGetString(GL_VENDOR));
+    glDriverDescription = vendor + " | " + renderer + " | " + version + " | " + glslver;
 
     cout << "OpenGL [ " << version << " ] "
          << "with GLSL [ " << glslver << " ] "
          << "on renderer [ " << renderer << " ]" << endl;
 }
 
+// --------------------------------------------------------------------------
+// OpenGL debug output (KHR_debug), compiled out of release (NDEBUG) builds
+
+#ifndef NDEBUG
+
+// messages less severe than this are filtered out by the driver
+const GLenum DEBUG_MIN_SEVERITY = GL_DEBUG_SEVERITY_LOW;
+
+// the same message id is reported at most this many times per second
+const int DEBUG_MAX_REPEATS_PER_SECOND = 5;
+
+struct MyDebugOutput
+{
+    // true once our callback has been installed on the context
+    bool            enabled;
+
+    // set by the callback when an error is reported, cleared by CheckGLErrors()
+    atomic<bool>    errorRaised;
+
+    // rate limiting state, the callback may run on a driver thread
+    mutex           lock;
+    double          windowStart;
+    int             suppressed;
+    map<GLuint, int> repeats;
+
+    MyDebugOutput() : enabled(false), errorRaised(false), windowStart(0.0), suppressed(0)
+    {}
+};
+
+MyDebugOutput debugOutput;
+
+const char *DebugSourceName(GLenum source)
+{
+    switch (source) {
+    case GL_DEBUG_SOURCE_API:               return "API";
+    case GL_DEBUG_SOURCE_WINDOW_SYSTEM:     return "window system";
+    case GL_DEBUG_SOURCE_SHADER_COMPILER:   return "shader compiler";
+    case GL_DEBUG_SOURCE_THIRD_PARTY:       return "third party";
+    case GL_DEBUG_SOURCE_APPLICATION:       return "application";
+    default:                                return "other";
+    }
+}
+
+const char *DebugTypeName(GLenum type)
+{
+    switch (type) {
+    case GL_DEBUG_TYPE_ERROR:               return "ERROR";
+    case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "DEPRECATED";
+    case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:  return "UNDEFINED BEHAVIOR";
+    case GL_DEBUG_TYPE_PORTABILITY:         return "PORTABILITY";
+    case GL_DEBUG_TYPE_PERFORMANCE:         return "PERFORMANCE";
+    default:                                return "MESSAGE";
+    }
+}
+
+const char *DebugSeverityName(GLenum severity)
+{
+    switch (severity) {
+    case GL_DEBUG_SEVERITY_HIGH:            return "high";
+    case GL_DEBUG_SEVERITY_MEDIUM:          return "medium";
+    case GL_DEBUG_SEVERITY_LOW:             return "low";
+    default:                                return "notification";
+    }
+}
+
+// receives messages from the driver, possibly on one of its own threads
+void APIENTRY DebugMessageCallback(GLenum source, GLenum type, GLuint id, GLenum severity,
+                                   GLsizei length, const GLchar *message, const void *userParam)
+{
+    MyDebugOutput *output = (MyDebugOutput *)userParam;
+    if (type == GL_DEBUG_TYPE_ERROR)
+        output->errorRaised = true;
+
+    lock_guard<mutex> guard(output->lock);
+
+    // start a new rate limiting window every second
+    double now = glfwGetTime();
+    if (now - output->windowStart >= 1.0)
+    {
+        if (output->suppressed > 0)
+            cout << "OpenGL DEBUG:  (" << output->suppressed
+                 << " repeated messages suppressed)" << endl;
+        output->windowStart = now;
+        output->suppressed = 0;
+        output->repeats.clear();
+    }
+
+    if (++output->repeats[id] > DEBUG_MAX_REPEATS_PER_SECOND)
+    {
+        output->suppressed++;
+        return;
+    }
+
+    cout << "OpenGL " << DebugTypeName(type) << " [" << DebugSourceName(source)
+         << ", " << DebugSeverityName(severity) << ", id " << id << "]:  "
+         << string(message, length > 0 ? length : strlen(message)) << endl;
+}
+
+#endif
+
+// installs our debug message callback if the context was created with the
+// debug flag and supports KHR_debug, otherwise errors are polled as before
+void InitializeDebugOutput()
+{
+#ifndef NDEBUG
+    GLint flags = 0, major = 0, minor = 0;
+    glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+
+    bool supported = (major > 4 || (major == 4 && minor >= 3))
+                     || glfwExtensionSupported("GL_KHR_debug");
+    if (!(flags & GL_CONTEXT_FLAG_DEBUG_BIT) || !supported)
+    {
+        cout << "OpenGL debug output unavailable, polling glGetError instead" << endl;
+        return;
+    }
+
+    // clear anything raised before the callback existed
+    CheckGLErrors();
+
+    glEnable(GL_DEBUG_OUTPUT);
+    glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    glDebugMessageCallback(DebugMessageCallback, &debugOutput);
+
+    // only let messages at or above the minimum severity through
+    const GLenum severities[] = { GL_DEBUG_SEVERITY_HIGH, GL_DEBUG_SEVERITY_MEDIUM,
+                                  GL_DEBUG_SEVERITY_LOW, GL_DEBUG_SEVERITY_NOTIFICATION };
+    glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, NULL, GL_FALSE);
+    for (int i = 0; i < 4; i++)
+    {
+        glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, severities[i], 0, NULL, GL_TRUE);
+        if (severities[i] == DEBUG_MIN_SEVERITY) break;
+    }
+
+    debugOutput.enabled = true;
+    cout << "OpenGL debug output enabled (minimum severity "
+         << DebugSeverityName(DEBUG_MIN_SEVERITY) << ")" << endl;
+#endif
+}
+
+// messages are delivered synchronously during start-up so that the error
+// checks in the initialization functions see them, after that the driver is
+// free to report them from its own thread
+void BeginAsynchronousDebugOutput()
+{
+#ifndef NDEBUG
+    if (debugOutput.enabled)
+        glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+#endif
+}
+
 bool CheckGLErrors()
 {
+#ifndef NDEBUG
+    // errors are reported through the debug callback, so just consume its flag
+    // rather than stalling the pipeline on glGetError
+    if (debugOutput.enabled)
+        return debugOutput.errorRaised.exchange(false);
+#endif
+
     bool error = false;
     for (GLenum flag = glGetError(); flag != GL_NO_ERROR; flag = glGetError())
     {
@@ -900,6 +6214,31 @@ bool CheckGLErrors()
     return error;
 }
 
+// glBufferData that adds its bytes and time to the render statistics, the
+// time is what the driver takes to copy the data out of our memory
+void UploadBufferData(GLenum target, GLsizeiptr size, const void *data, GLenum usage)
+{
+    AllocationScope allocations("upload");
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    glBufferData(target, size, data, usage);
+    chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+
+    renderStats.uploadMilliseconds += elapsed.count();
+    renderStats.uploadBytes += size;
+}
+
+// glBufferSubData counterpart of UploadBufferData()
+void UploadBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void *data)
+{
+    AllocationScope allocations("upload");
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    glBufferSubData(target, offset, size, data);
+    chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+
+    renderStats.uploadMilliseconds += elapsed.count();
+    renderStats.uploadBytes += size;
+}
+
 // --------------------------------------------------------------------------
 // OpenGL shader support functions
 
@@ -923,6 +6262,28 @@ string LoadSource(const string &filename)
     return source;
 }
 
+// inserts colour.glsl after the #version line of the source, which has to
+// come first, and numbers the lines after it as in the file so that compiler
+// messages still point at the right line
+string AddSharedShaderCode(const string &source)
+{
+    static const string shared = LoadSource("colour.glsl");
+    if (shared.empty()) return string();
+
+    size_t version = source.find("#version");
+    if (version == string::npos)
+        return source;
+    size_t end = source.find('\n', version);
+    if (end == string::npos)
+        return source;
+
+    int line = 2 + count(source.begin(), source.begin() + end, '\n');
+    char definitions[96];
+    snprintf(definitions, sizeof(definitions), "#define SQUARE_COLOUR_STEP %#.9g\n", SQUARE_COLOUR_STEP);
+    return source.substr(0, end + 1) + definitions + shared
+           + "\n#line " + to_string(line) + "\n" + source.substr(end + 1);
+}
+
 // creates and returns a shader object compiled from the given source
 GLuint CompileShader(GLenum shaderType, const string &source)
 {
@@ -961,6 +6322,9 @@ GLuint LinkProgram(GLuint vertexShader, GLuint fragmentShader)
     if (vertexShader)   glAttachShader(programObject, vertexShader);
     if (fragmentShader) glAttachShader(programObject, fragmentShader);
 
+    // ask for a binary we can store in the program cache
+    glProgramParameteri(programObject, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
     // try linking the program with given attachments
     glLinkProgram(programObject);
 
@@ -979,4 +6343,135 @@ GLuint LinkProgram(GLuint vertexShader, GLuint fragmentShader)
 
     return programObject;
 }
+// --------------------------------------------------------------------------
+// OpenGL program binary cache
+
+// linked program binaries are stored here, one file per cache key
+const string SHADER_CACHE_DIRECTORY = "shadercache";
+
+struct ProgramBinaryHeader
+{
+    char        magic[4];
+    uint32_t    version;
+    uint32_t    format;
+    uint32_t    length;
+};
+
+const uint32_t PROGRAM_BINARY_VERSION = 1;
+
+// 64-bit FNV-1a hash, continuing from the given hash value
+uint64_t HashBytes(const void *data, size_t size, uint64_t hash)
+{
+    const unsigned char *bytes = (const unsigned char *)data;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// the key covers both source texts and the driver that produced the binary,
+// so editing a shader or updating the driver invalidates the cached copy
+string ProgramCacheKey(const string &vertexSource, const string &fragmentSource)
+{
+    uint64_t hash = HashBytes(vertexSource.data(), vertexSource.size());
+    hash = HashBytes("", 1, hash);
+    hash = HashBytes(fragmentSource.data(), fragmentSource.size(), hash);
+    hash = HashBytes("", 1, hash);
+    hash = HashBytes(glDriverDescription.data(), glDriverDescription.size(), hash);
+
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx", (unsigned long long)hash);
+    return name;
+}
+
+string ProgramCachePath(const string &key)
+{
+    return SHADER_CACHE_DIRECTORY + "/program-" + key + ".bin";
+}
+
+// returns a linked program loaded from the cache, or zero if there is no
+// usable binary for this key
+GLuint LoadProgramBinary(const string &key)
+{
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    if (formats == 0) return 0;
+
+    ifstream input(ProgramCachePath(key), ios::binary);
+    if (!input) return 0;
+
+    ProgramBinaryHeader header;
+    if (!input.read((char *)&header, sizeof(header))
+        || memcmp(header.magic, "SPBC", 4) != 0
+        || header.version != PROGRAM_BINARY_VERSION)
+        return 0;
+
+    // a corrupt length must not become an empty read or a huge allocation
+    streamoff start = input.tellg();
+    input.seekg(0, ios::end);
+    streamoff remaining = input.tellg() - start;
+    input.seekg(start);
+    if (header.length == 0 || (streamoff)header.length > remaining) return 0;
+
+    // a format from another driver would raise GL_INVALID_ENUM
+    vector<GLint> supported(formats);
+    glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, &supported[0]);
+    if (find(supported.begin(), supported.end(), (GLint)header.format) == supported.end()) return 0;
+
+    vector<char> binary(header.length);
+    if (!input.read(&binary[0], binary.size())) return 0;
+
+    // the driver may still reject the binary, in which case we recompile
+    GLuint programObject = glCreateProgram();
+    glProgramBinary(programObject, header.format, &binary[0], header.length);
+
+    GLint status;
+    glGetProgramiv(programObject, GL_LINK_STATUS, &status);
+    if (status == GL_FALSE)
+    {
+        cout << "Cached shader program " << key << " was rejected, recompiling" << endl;
+        glDeleteProgram(programObject);
+
+        // whatever the driver raised is not an error of the recompiled program
+        CheckGLErrors();
+        return 0;
+    }
+    return programObject;
+}
+
+// writes the binary of a successfully linked program to the cache
+void SaveProgramBinary(GLuint program, const string &key)
+{
+    GLint formats = 0, status = GL_FALSE, length = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (formats == 0 || status == GL_FALSE) return;
+
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+
+    ProgramBinaryHeader header;
+    memcpy(header.magic, "SPBC", 4);
+    header.version = PROGRAM_BINARY_VERSION;
+
+    vector<char> binary(length);
+    GLenum format;
+    glGetProgramBinary(program, length, &length, &format, &binary[0]);
+    header.format = format;
+    header.length = length;
+
+    mkdir(SHADER_CACHE_DIRECTORY.c_str(), 0755);
+    ofstream output(ProgramCachePath(key), ios::binary);
+    if (output)
+    {
+        output.write((const char *)&header, sizeof(header));
+        output.write(&binary[0], length);
+    }
+    else {
+        cout << "WARNING: Could not write shader program cache "
+             << ProgramCachePath(key) << endl;
+    }
+}
 // ==========================================================================
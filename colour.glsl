@@ -0,0 +1,26 @@
+// ==========================================================================
+// Colour functions shared by the shader programs
+//
+// InitializeProgram() inserts this file after the #version line of every
+// shader it loads, with SQUARE_COLOUR_STEP defined by the main program.
+// ==========================================================================
+
+// 0 for the colours of the assignment, 1 for a heat palette over the same
+// parameter, switched without touching the geometry
+uniform int ColourScheme;
+
+// black through red and yellow to white as t goes from 0 to 1
+vec3 heat(float t)
+{
+    t = clamp(t, 0.0, 1.0);
+    return vec3(smoothstep(0.0, 0.4, t), smoothstep(0.3, 0.7, t), smoothstep(0.6, 1.0, t));
+}
+
+// colour of the assignment for shape number shape of part one, squares and
+// diamonds take turns from the outside in and a square shares its index with
+// the diamond inside it
+vec3 squareColour(int shape)
+{
+    float Dcolor = float(shape / 2) * SQUARE_COLOUR_STEP + SQUARE_COLOUR_STEP;
+    return (shape % 2 == 0) ? vec3(Dcolor) : vec3(0.001, 0.001, 1.0 - Dcolor - 0.01);
+}
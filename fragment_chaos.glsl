@@ -0,0 +1,18 @@
+// ==========================================================================
+// Fragment program for the chaos game point cloud of part three
+//
+// Points are added into the accumulation texture, the colour channels sum
+// the tints of the points that hit a pixel and alpha counts them.
+// ==========================================================================
+#version 410
+
+// colour received from vertex stage
+in vec3 Colour;
+
+// first output is mapped to the framebuffer's colour index by default
+out vec4 FragmentColour;
+
+void main(void)
+{
+    FragmentColour = vec4(Colour, 1.0);
+}
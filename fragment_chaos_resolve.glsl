@@ -0,0 +1,34 @@
+// ==========================================================================
+// Fragment program for showing the accumulated chaos game of part three
+//
+// The hits of every pixel are averaged over the frames drawn so far and tone
+// mapped, so the image only gets smoother as frames are added.
+// ==========================================================================
+#version 410
+
+// summed tints in the colour channels and the number of hits in alpha
+uniform sampler2D Accumulation;
+
+// frames added into the accumulation texture
+uniform float Frames;
+
+// hits per pixel and frame if the points were spread over the whole window,
+// a pixel hit that often is drawn almost fully coloured
+uniform float Exposure;
+
+// first output is mapped to the framebuffer's colour index by default
+out vec4 FragmentColour;
+
+void main(void)
+{
+    vec4 sum = texelFetch(Accumulation, ivec2(gl_FragCoord.xy), 0);
+    float density = sum.a / (Frames * Exposure);
+    float coverage = 1.0 - exp(-density);
+
+    vec3 colour = sum.rgb / max(sum.a, 1.0);
+    if (ColourScheme == 1)
+        colour = heat(log2(1.0 + density) / 8.0);
+
+    // on the white background of part three
+    FragmentColour = vec4(mix(vec3(1.0), colour, coverage), 0.0);
+}
@@ -0,0 +1,26 @@
+// ==========================================================================
+// Fragment program for the 3D Sierpinski tetrahedron and Menger sponge
+//
+// Vertices are shared between faces, so there is no per-vertex normal. Every
+// face is flat, and its normal is the cross product of the screen-space
+// derivatives of the interpolated position.
+// ==========================================================================
+#version 410
+
+// interpolated colour and lattice position received from vertex stage
+in vec3 Colour;
+in vec3 Position;
+
+// first output is mapped to the framebuffer's colour index by default
+out vec4 FragmentColour;
+
+const vec3 LightDirection = vec3(0.36, 0.8, 0.48);
+
+void main(void)
+{
+    vec3 normal = normalize(cross(dFdx(Position), dFdy(Position)));
+
+    // ambient plus diffuse light from a fixed direction in model space
+    float diffuse = max(dot(normal, LightDirection), 0.0);
+    FragmentColour = vec4(Colour * (0.3 + 0.7 * diffuse), 1);
+}
@@ -3,7 +3,20 @@
  *
  *      1 - cd to the directory where boilerplate.cpp
  *      2 - run the following command
- *          $ g++ -std=c++11 boilerplate.cpp -lGL -lglfw
+ *          $ g++ -std=c++14 -O2 -pthread boilerplate.cpp -lGL -lglfw
+ *
+ *          (-O2 lets the compiler turn the copy loops of the part three builder into SIMD
+ *          instructions, without it deep levels take several times longer to generate)
+ *
+ *          (C++14 is needed for the constexpr tables the first levels of parts one, three and four
+ *          are baked into at compile time, those levels are uploaded straight from the binary)
+ *
+ *          (add -DNDEBUG for a release build, this compiles out the OpenGL debug output
+ *          and the per-frame error checks)
+ *
+ *          (add -DTRACK_ALLOCATIONS to count every allocation by the scope making it, a table of
+ *          them is printed on exit, and --benchmark --assert-no-allocations then fails when the
+ *          render loop still allocates after its first few frames)
  *
  *      3 - then run
  *          $ ./a.out
@@ -13,6 +26,82 @@
  *          then use the left/right arrow keys to navigate the scens and use the up/down arrow keys to increase the levels
  *          of each iteration.
  *
- *      5 - Thanks :)
+ *          Part four is the Sierpinski carpet (levels 1 to 7), parts five and six are the Sierpinski
+ *          tetrahedron (levels 1 to 8) and the Menger sponge (levels 1 to 5) in 3D, all reached with the
+ *          left/right arrow keys like the other parts. Drag with the left mouse button to turn the camera
+ *          around the solids and scroll to zoom.
+ *
+ *          Press (G) to generate the Sierpinski triangle of part three with a compute shader on the GPU
+ *          instead of the CPU (needs OpenGL 4.3 or GL_ARB_compute_shader, otherwise the CPU is used).
+ *
+ *          Press (O) to draw part three out-of-core, generated and uploaded in fixed-size chunks. Levels
+ *          too large for the memory budget always use this mode, so memory use stays bounded at any level.
+ *          Otherwise only the left third of the triangle is generated, cached and uploaded, and the
+ *          vertex shader draws it three times, moved into place and tinted per instance.
+ *
+ *          Press (P) to draw part three as a chaos game point cloud instead: every frame the GPU adds a
+ *          million random points into a float texture, seeded by a hash of their index, and the window
+ *          shows their average so far. Memory use is one texture the size of the window at any level,
+ *          and the image keeps converging for 64 frames before the window waits for events again.
+ *
+ *          In parts one and three, scroll to zoom around the mouse cursor and drag with the left mouse
+ *          button to move around, or press (Z) and (X) to zoom in and out and (R) to see the whole part
+ *          again. Zoomed geometry is generated in double precision relative to the camera, so it stays
+ *          exact up to a zoom of 10^12, and only what is in the window is generated at any level.
+ *
+ *          In part three the smallest triangle under the mouse cursor is highlighted in yellow. It is
+ *          found by walking down one level at a time from the cursor position, without searching the
+ *          geometry, so it works at any level and zoom in all the drawing modes above.
+ *
+ *          Press (C) to switch parts one to three between the assignment colours and a heat palette.
+ *          Switching never regenerates or uploads anything. Part one is drawn as instances of a single
+ *          unit square, scaled and turned by the vertex shader, and the spiral of part two uploads
+ *          nothing at all, so neither generates anything on the CPU when its level changes.
+ *
+ *          Press (D) to show all the parts side by side, the up/down arrow keys then change the levels of
+ *          every part at once. All parts are drawn with two multi-draw-indirect calls (needs OpenGL 4.3).
+ *
+ *          The size of every part and level is known before it is generated. A scene that would hold more
+ *          than the memory budget (256 MB by default, set with --host-budget and --gpu-budget in MB) is
+ *          drawn in chunks (part three) or at the deepest level that fits (the carpet, the solids and the
+ *          dashboard), with a message saying so, and the benchmark reports the peak memory held.
+ *          Part three goes up to level 41, and levels past 14, whose triangles are smaller than a pixel,
+ *          are drawn at level 14 until zoomed in.
+ *
+ *      5 - to check the compute shader against the CPU generator (works on Mesa llvmpipe too)
+ *          $ ./a.out --verify-compute 10
+ *
+ *          and to check that the threaded builder of part three writes exactly the floats of the
+ *          recursive generator, on as many threads as --threads asks for
+ *          $ ./a.out --verify-builder 12 --threads 4
+ *
+ *      6 - to export a part as SVG, OBJ or raw binary without opening a window (use - as the file
+ *          name to write to stdout), memory use stays the same whatever the level
+ *          $ ./a.out --export svg sierpinski.svg 3 8
+ *
+ *      7 - to render the density of any iterated function system, read from a text file with one
+ *          "a b c d e f p" affine map per line, on all cores without opening a window (ifs/ has the
+ *          Sierpinski triangle, the Barnsley fern, the Heighway dragon and the Koch curve), printing
+ *          the samples per second
+ *          $ ./a.out --ifs ifs/fern.ifs fern.ppm --samples 100000000 --size 1024x1024
+ *
+ *      8 - to benchmark a scene without touching the keyboard, rendering continuously and printing the
+ *          frame-time percentiles, generation time, upload bandwidth and peak geometry memory at the end
+ *          $ ./a.out --benchmark --part 3 --level 12 --frames 300 --size 1280x720
+ *
+ *          (--part and --level also work without --benchmark, and --zoom 1e9 --center <x>,<y> starts
+ *          parts one and three zoomed in, run ./a.out --help for all options)
+ *
+ *      9 - to reproduce a session, record its key events and replay them later in a hidden window, which
+ *          prints the generation time and frame latency of every event (--replay-speed 0 replays them
+ *          back to back, 2 twice as fast as recorded)
+ *          $ ./a.out --record session.keys
+ *          $ ./a.out --replay session.keys --replay-speed 1
+ *
+ *          (the hidden window still needs a display, so on a machine without one, such as a CI
+ *          runner, start the replay under a virtual X server)
+ *          $ xvfb-run ./a.out --replay session.keys --replay-speed 0
+ *
+ *      10 - Thanks :)
  *
  *
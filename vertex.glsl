@@ -11,6 +11,19 @@
 layout(location = 0) in vec2 VertexPosition;
 layout(location = 1) in vec3 VertexColour;
 
+// per-instance offset and colour tint of the thirds of the Sierpinski triangle
+layout(location = 2) in vec2 InstanceOffset;
+layout(location = 3) in vec3 InstanceTint;
+
+// how the colour is found: 0 from the VertexColour attribute, 1 for the
+// nested squares of part one from the vertex index alone, which has no colour
+// attribute at all, and 2 for a third of the Sierpinski triangle moved and
+// tinted into place by its instance
+uniform int ColourRule;
+
+// number of squares of part one
+uniform float ColourExtent;
+
 // output to be interpolated between vertices and passed to the fragment stage
 out vec3 Colour;
 
@@ -19,6 +32,24 @@ void main()
     // assign vertex position without modification
     gl_Position = vec4(VertexPosition, 0.0, 1.0);
 
+    vec3 colour = VertexColour;
+    float parameter = max(max(VertexColour.r, VertexColour.g), VertexColour.b);
+
+    if (ColourRule == 2)
+    {
+        // the vertices are those of the left third, brightening the red channel
+        gl_Position.xy += InstanceOffset;
+        colour = VertexColour.r * InstanceTint;
+    }
+
+    if (ColourRule == 1)
+    {
+        // squares and diamonds take turns, each four lines of two vertices
+        int shape = gl_VertexID / 8;
+        colour = squareColour(shape);
+        parameter = (float(shape / 2) + 0.5) / ColourExtent;
+    }
+
     // assign output colour to be interpolated
-    Colour = VertexColour;
+    Colour = (ColourScheme == 1) ? heat(parameter) : colour;
 }
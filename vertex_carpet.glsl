@@ -0,0 +1,27 @@
+// ==========================================================================
+// Vertex program for the instanced Sierpinski carpet
+//
+// Every square of the carpet is one instance of a unit quad, placed by its
+// per-instance lower left corner and side length.
+// ==========================================================================
+#version 410
+
+// location indices for these attributes correspond to those specified in the
+// InitializeCarpet() function of the main program
+layout(location = 0) in vec2 VertexPosition;
+layout(location = 1) in vec3 VertexColour;
+
+// per-instance lower left corner in xy and side length in z (divisor 1)
+layout(location = 2) in vec3 SquareOffsetScale;
+
+// output to be interpolated between vertices and passed to the fragment stage
+out vec3 Colour;
+
+void main()
+{
+    // scale the unit quad to the square and move it into place
+    gl_Position = vec4(SquareOffsetScale.xy + VertexPosition * SquareOffsetScale.z, 0.0, 1.0);
+
+    // assign output colour to be interpolated
+    Colour = VertexColour;
+}
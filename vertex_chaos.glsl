@@ -0,0 +1,56 @@
+// ==========================================================================
+// Vertex program for the chaos game point cloud of part three
+//
+// Every vertex is one independent run of the chaos game, seeded from its
+// index by a stateless hash, so the vertex array is empty and nothing is
+// uploaded. A run starts anywhere in the window and jumps halfway towards a
+// random corner of the triangle again and again, which brings it onto the
+// Sierpinski triangle whatever the level.
+// ==========================================================================
+#version 410
+
+// corners of the triangle of level one, left, top and right, and the colour
+// of the third each of them pulls a point into
+const vec2 Corners[3] = vec2[3](vec2(-0.5, -0.5), vec2(0.0, 0.5), vec2(0.5, -0.5));
+const vec3 Tints[3] = vec3[3](vec3(1.0, 0.0, 0.0), vec3(0.0, 0.0, 1.0), vec3(0.0, 1.0, 0.0));
+
+// index of the first run of this frame, so that every frame adds new points
+uniform uint FirstPoint;
+
+// jumps of every run, each one halves the distance to the triangle
+uniform int Iterations;
+
+// world position in the middle of the window and window half-widths per
+// world unit, as for the zoomed geometry of the main program
+uniform vec2 ViewCenter;
+uniform float ViewZoom;
+
+// output to be passed to the fragment stage
+out vec3 Colour;
+
+// PCG hash, a bijection of 32 bits with good avalanche, from Jarzynski and
+// Olano, "Hash Functions for GPU Rendering"
+uint hash(uint value)
+{
+    uint state = value * 747796405u + 2891336453u;
+    uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+void main()
+{
+    uint state = hash(FirstPoint + uint(gl_VertexID));
+    vec2 point = vec2(state & 0xffffu, state >> 16u) / 65535.0 * 2.0 - 1.0;
+
+    int corner = 0;
+    for (int i = 0; i < Iterations; i++)
+    {
+        state = hash(state);
+        corner = int(state % 3u);
+        point = 0.5 * (point + Corners[corner]);
+    }
+
+    // the last jump decides which third the point lies in
+    gl_Position = vec4((point - ViewCenter) * ViewZoom, 0.0, 1.0);
+    Colour = Tints[corner];
+}
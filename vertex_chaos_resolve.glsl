@@ -0,0 +1,13 @@
+// ==========================================================================
+// Vertex program for showing the accumulated chaos game of part three
+//
+// One triangle from an empty vertex array covers the whole window.
+// ==========================================================================
+#version 410
+
+void main()
+{
+    // (-1, -1), (3, -1) and (-1, 3)
+    vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,29 @@
+// ==========================================================================
+// Vertex program for the split-screen dashboard
+//
+// Every scene is one command of a multi-draw-indirect call. The base instance
+// of each command selects that scene's viewport rectangle from the per-draw
+// attribute below, so one draw call covers all scenes of a primitive type.
+// ==========================================================================
+#version 410
+
+// location indices for these attributes correspond to those specified in the
+// InitializeDashboard() function of the main program
+layout(location = 0) in vec2 VertexPosition;
+layout(location = 1) in vec3 VertexColour;
+
+// per-draw viewport region in normalized device coordinates, offset in xy
+// and scale in zw (attribute divisor 1, indexed by the base instance)
+layout(location = 2) in vec4 ViewportRect;
+
+// output to be interpolated between vertices and passed to the fragment stage
+out vec3 Colour;
+
+void main()
+{
+    // place the scene inside its own region of the screen
+    gl_Position = vec4(VertexPosition * ViewportRect.zw + ViewportRect.xy, 0.0, 1.0);
+
+    // assign output colour to be interpolated
+    Colour = VertexColour;
+}
@@ -0,0 +1,27 @@
+// ==========================================================================
+// Vertex program for the 3D Sierpinski tetrahedron and Menger sponge
+//
+// Positions are integer lattice coordinates, the model-view-projection
+// matrix scales the lattice into a unit box in front of the camera.
+// ==========================================================================
+#version 410
+
+// location indices for these attributes correspond to those specified in the
+// InitializeSolid() function of the main program
+layout(location = 0) in vec3 VertexPosition;
+layout(location = 1) in vec3 VertexColour;
+
+uniform mat4 ModelViewProjection;
+
+// output to be interpolated between vertices and passed to the fragment stage
+out vec3 Colour;
+out vec3 Position;
+
+void main()
+{
+    gl_Position = ModelViewProjection * vec4(VertexPosition, 1.0);
+
+    // the fragment stage derives the face normal from the lattice position
+    Position = VertexPosition;
+    Colour = VertexColour;
+}
@@ -0,0 +1,25 @@
+// ==========================================================================
+// Vertex program for the spiral of part two
+//
+// The spiral is one line strip drawn from an empty vertex array, every vertex
+// computes its position and colour from gl_VertexID and the uniforms.
+// ==========================================================================
+#version 410
+
+// the parameter at the end of the spiral, 2 pi times the number of rotations
+uniform float SpiralExtent;
+
+// output to be interpolated between vertices and passed to the fragment stage
+out vec3 Colour;
+
+void main()
+{
+    // vertex i of the line strip is the point of the spiral at the parameter
+    // 0.01 i, scaled so that the last rotation touches the window edge
+    float t = 0.01 * float(gl_VertexID);
+    gl_Position = vec4(t * cos(t) / SpiralExtent, -t * sin(t) / SpiralExtent, 0.0, 1.0);
+
+    // and gets bluer the further along it is
+    float parameter = t / SpiralExtent;
+    Colour = (ColourScheme == 1) ? heat(parameter) : vec3(0.0, 0.0, parameter);
+}
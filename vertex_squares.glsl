@@ -0,0 +1,33 @@
+// ==========================================================================
+// Vertex program for the nested squares and diamonds of part one
+//
+// Every square and diamond is one instance of the same unit square, scaled and
+// turned into place from gl_InstanceID alone.
+// ==========================================================================
+#version 410
+
+// corner of the unit square, drawn as a line loop
+layout(location = 0) in vec2 VertexPosition;
+
+// number of squares, half the number of instances
+uniform float ColourExtent;
+
+// output to be interpolated between vertices and passed to the fragment stage
+out vec3 Colour;
+
+void main()
+{
+    // squares and diamonds take turns from the outside in, every square is half
+    // the size of the one before it and the diamond inside it joins the
+    // midpoints of its sides, the next corner being this one turned clockwise
+    int shape = gl_InstanceID;
+    int index = shape / 2;
+    vec2 corner = VertexPosition;
+    if (shape % 2 == 1)
+        corner = 0.5 * (corner + vec2(corner.y, -corner.x));
+    gl_Position = vec4(0.9 * exp2(-float(index)) * corner, 0.0, 1.0);
+
+    // assign output colour to be interpolated
+    float parameter = (float(index) + 0.5) / ColourExtent;
+    Colour = (ColourScheme == 1) ? heat(parameter) : squareColour(shape);
+}